@@ -0,0 +1,96 @@
+// Times the JS command decoder of generated apps under Node.
+//
+// Each argument is a <label>:<dist dir> holding an app.js/app.wasm pair. The
+// builds made by run.sh share one app.wasm per example and differ only in
+// app.js (--dispatch=switch vs --dispatch=table), so the time spent inside
+// webcc_js_flush is the decoder being compared.
+//
+//   node bench.mjs switch:dist/canvas/switch table:dist/canvas/table [--frames 2000] [--warmup 300] [--click] [--json out.json]
+
+import fs from 'node:fs';
+import path from 'node:path';
+import vm from 'node:vm';
+import { findClickable, makeGlobals } from './dom_stub.mjs';
+
+function parseArgs(argv) {
+    const opts = { frames: 2000, warmup: 300, click: false, json: null, variants: [] };
+    for (let i = 0; i < argv.length; ++i) {
+        const a = argv[i];
+        if (a === '--frames') opts.frames = parseInt(argv[++i], 10);
+        else if (a === '--warmup') opts.warmup = parseInt(argv[++i], 10);
+        else if (a === '--click') opts.click = true;
+        else if (a === '--json') opts.json = argv[++i];
+        else {
+            const sep = a.indexOf(':');
+            opts.variants.push(sep < 0 ? { label: path.basename(a), dir: a } : { label: a.slice(0, sep), dir: a.slice(sep + 1) });
+        }
+    }
+    return opts;
+}
+
+async function runVariant({ label, dir }, opts) {
+    const g = makeGlobals();
+    const stats = { flushes: 0, bytes: 0, ms: 0 };
+
+    g.fetch = async () => ({ arrayBuffer: async () => fs.readFileSync(path.join(dir, 'app.wasm')) });
+    g.WebAssembly = {
+        instantiate: (bytes, imports) => {
+            const flush = imports.env.webcc_js_flush;
+            imports.env.webcc_js_flush = (ptr, size) => {
+                const t0 = performance.now();
+                flush(ptr, size);
+                stats.ms += performance.now() - t0;
+                stats.flushes++;
+                stats.bytes += size;
+            };
+            return WebAssembly.instantiate(bytes, imports);
+        },
+    };
+
+    const context = vm.createContext(g);
+    vm.runInContext(fs.readFileSync(path.join(dir, 'app.js'), 'utf8'), context, { filename: path.join(dir, 'app.js') });
+    // Let run() instantiate the module and call main().
+    for (let i = 0; i < 50 && g.raf.length === 0; ++i) await new Promise((r) => setTimeout(r, 1));
+    if (g.raf.length === 0) throw new Error(`${label}: no main loop was started`);
+
+    let t = 0;
+    const step = () => {
+        t += 1000 / 60;
+        if (opts.click) {
+            const target = findClickable(g.document.body);
+            const onClick = g.document.body.listeners.get('click');
+            if (target && onClick) onClick({ target });
+        }
+        for (const cb of g.raf.splice(0)) cb(t);
+    };
+
+    for (let i = 0; i < opts.warmup; ++i) step();
+    stats.flushes = stats.bytes = stats.ms = 0;
+    for (let i = 0; i < opts.frames; ++i) step();
+
+    return {
+        label,
+        frames: opts.frames,
+        flushes: stats.flushes,
+        bytes_per_frame: stats.bytes / opts.frames,
+        flush_us_per_frame: (stats.ms * 1000) / opts.frames,
+        ns_per_byte: stats.bytes ? (stats.ms * 1e6) / stats.bytes : 0,
+    };
+}
+
+const opts = parseArgs(process.argv.slice(2));
+if (opts.variants.length === 0) {
+    console.error('usage: node bench.mjs <label>:<dist dir> ... [--frames N] [--warmup N] [--click] [--json out.json]');
+    process.exit(1);
+}
+
+const results = [];
+for (const v of opts.variants) results.push(await runVariant(v, opts));
+
+const base = results[0];
+for (const r of results) {
+    const speedup = base.flush_us_per_frame / r.flush_us_per_frame;
+    console.log(`${r.label.padEnd(12)} ${r.flush_us_per_frame.toFixed(2).padStart(9)} us/frame in flush  ` +
+        `${r.bytes_per_frame.toFixed(0).padStart(7)} B/frame  ${r.ns_per_byte.toFixed(2).padStart(7)} ns/B  x${speedup.toFixed(2)}`);
+}
+if (opts.json) fs.writeFileSync(opts.json, JSON.stringify(results, null, 2) + '\n');
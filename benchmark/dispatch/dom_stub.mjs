@@ -0,0 +1,177 @@
+// Minimal headless stand-ins for the browser objects the generated app.js
+// touches, so its command decoder can be timed under Node. Every DOM, canvas
+// and WebGL call is a plain method doing (almost) nothing, which leaves the
+// decoder as the cost being measured.
+
+const noop = () => {};
+
+const CANVAS_2D_METHODS = [
+    'arc', 'arcTo', 'beginPath', 'bezierCurveTo', 'clearRect', 'clip', 'closePath',
+    'drawImage', 'ellipse', 'fill', 'fillRect', 'fillText', 'lineTo', 'moveTo',
+    'quadraticCurveTo', 'rect', 'resetTransform', 'restore', 'rotate', 'save', 'scale',
+    'setTransform', 'stroke', 'strokeRect', 'strokeText', 'transform', 'translate',
+];
+
+export class FakeContext2D {
+    constructor(canvas) {
+        this.canvas = canvas;
+        this.fillStyle = '#000';
+        this.strokeStyle = '#000';
+        this.font = '10px sans-serif';
+        this.lineWidth = 1;
+        this.globalAlpha = 1;
+        this.calls = 0;
+    }
+    measureText(text) { return { width: text.length * 8 }; }
+}
+for (const name of CANVAS_2D_METHODS) {
+    FakeContext2D.prototype[name] = function () { this.calls++; };
+}
+
+// WebGL is too wide to list by hand: constants (upper-case names) read as 1,
+// create* and getUniformLocation hand out fresh objects, get*Parameter
+// reports success, and everything else is a counted no-op.
+export function makeWebGLContext(canvas) {
+    const gl = { canvas, calls: 0, drawingBufferWidth: canvas.width, drawingBufferHeight: canvas.height };
+    const methods = new Map();
+    return new Proxy(gl, {
+        get(target, name) {
+            if (name in target || typeof name !== 'string') return target[name];
+            if (/^[A-Z0-9_]+$/.test(name)) return 1;
+            let fn = methods.get(name);
+            if (!fn) {
+                if (name.startsWith('create') || name === 'getUniformLocation') fn = () => { target.calls++; return {}; };
+                else if (/^get\w*Parameter$/.test(name)) fn = () => { target.calls++; return true; };
+                else if (/^get\w*InfoLog$/.test(name)) fn = () => '';
+                else if (name === 'getAttribLocation' || name === 'getError') fn = () => 0;
+                else fn = () => { target.calls++; };
+                methods.set(name, fn);
+            }
+            return fn;
+        },
+    });
+}
+
+export class FakeElement {
+    constructor(tag, doc) {
+        this.tagName = String(tag).toUpperCase();
+        this.ownerDocument = doc;
+        this.children = [];
+        this.parentElement = null;
+        this.style = {};
+        this.dataset = {};
+        this.attributes = new Map();
+        this.listeners = new Map();
+        this.innerText = '';
+        this.innerHTML = '';
+        this.nodeValue = '';
+        this.value = '';
+        this.width = 300;
+        this.height = 150;
+        this.classList = { add: noop, remove: noop, toggle: noop, contains: () => false };
+    }
+    appendChild(child) {
+        if (child.parentElement) child.remove();
+        child.parentElement = this;
+        this.children.push(child);
+        return child;
+    }
+    insertBefore(child, ref) {
+        if (child.parentElement) child.remove();
+        child.parentElement = this;
+        const i = this.children.indexOf(ref);
+        this.children.splice(i < 0 ? this.children.length : i, 0, child);
+        return child;
+    }
+    removeChild(child) { child.remove(); return child; }
+    remove() {
+        const p = this.parentElement;
+        if (!p) return;
+        const i = p.children.indexOf(this);
+        if (i >= 0) p.children.splice(i, 1);
+        this.parentElement = null;
+    }
+    setAttribute(k, v) { this.attributes.set(k, String(v)); if (k === 'id') this.ownerDocument.ids.set(String(v), this); }
+    getAttribute(k) { return this.attributes.has(k) ? this.attributes.get(k) : null; }
+    removeAttribute(k) { this.attributes.delete(k); }
+    addEventListener(type, fn) { this.listeners.set(type, fn); }
+    removeEventListener(type) { this.listeners.delete(type); }
+    getBoundingClientRect() { return { left: 0, top: 0, width: this.width, height: this.height }; }
+    getContext(type) {
+        if (type === '2d') return (this.ctx2d ||= new FakeContext2D(this));
+        if (type === 'webgl' || type === 'webgl2') return (this.gl ||= makeWebGLContext(this));
+        return null;
+    }
+    focus() {}
+    blur() {}
+    click() {}
+    requestFullscreen() { return Promise.resolve(); }
+    requestPointerLock() {}
+}
+
+export class FakeDocument {
+    constructor() {
+        this.ids = new Map();
+        this.listeners = new Map();
+        this.currentScript = null;
+        this.title = '';
+        this.hidden = false;
+        this.visibilityState = 'visible';
+        this.body = new FakeElement('body', this);
+    }
+    createElement(tag) { return new FakeElement(tag, this); }
+    createTextNode(text) { const n = new FakeElement('#text', this); n.nodeValue = text; return n; }
+    createComment(text) { const n = new FakeElement('#comment', this); n.nodeValue = text; return n; }
+    getElementById(id) { return this.ids.get(id) || null; }
+    addEventListener(type, fn) { this.listeners.set(type, fn); }
+    removeEventListener(type) { this.listeners.delete(type); }
+    exitPointerLock() {}
+}
+
+// First element with a click-delegation id (data-c), depth first.
+export function findClickable(el) {
+    if (el.dataset && el.dataset.c !== undefined) return el;
+    for (const child of el.children) {
+        const hit = findClickable(child);
+        if (hit) return hit;
+    }
+    return null;
+}
+
+// Globals app.js reads while running. `raf` collects requestAnimationFrame
+// callbacks; the benchmark calls them to step frames.
+export function makeGlobals() {
+    const document = new FakeDocument();
+    const raf = [];
+    const window = {
+        location: { href: 'http://localhost/' },
+        listeners: new Map(),
+        addEventListener(type, fn) { this.listeners.set(type, fn); },
+        removeEventListener(type) { this.listeners.delete(type); },
+        scrollTo: noop,
+        open: noop,
+        innerWidth: 1280,
+        innerHeight: 720,
+        devicePixelRatio: 1,
+    };
+    return {
+        document,
+        window,
+        raf,
+        navigator: { userAgent: 'node' },
+        requestAnimationFrame: (fn) => { raf.push(fn); return raf.length; },
+        cancelAnimationFrame: noop,
+        setTimeout,
+        clearTimeout,
+        setInterval,
+        clearInterval,
+        queueMicrotask,
+        performance,
+        console,
+        TextDecoder,
+        TextEncoder,
+        URL,
+        Image: class extends FakeElement { constructor() { super('img', document); } },
+        Audio: class extends FakeElement { constructor() { super('audio', document); } play() { return Promise.resolve(); } pause() {} },
+    };
+}
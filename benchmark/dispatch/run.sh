@@ -0,0 +1,21 @@
+#!/bin/bash
+# Builds the canvas and DOM examples with both JS dispatch modes and times
+# their decoders under Node (see bench.mjs).
+set -e
+
+cd "$(dirname "$0")"
+ROOT=../..
+FRAMES=${FRAMES:-2000}
+
+for ex in canvas dom; do
+    for mode in switch table; do
+        out=dist/$ex/$mode
+        mkdir -p "$out"
+        "$ROOT/webcc" "$ROOT/examples/webcc_$ex/example.cc" --out "$out" --release --dispatch=$mode > /dev/null
+    done
+done
+
+echo "== canvas =="
+node bench.mjs switch:dist/canvas/switch table:dist/canvas/table --frames "$FRAMES" --json dist/canvas.json
+echo "== dom (one click per frame) =="
+node bench.mjs switch:dist/dom/switch table:dist/dom/table --frames "$FRAMES" --click --json dist/dom.json
@@ -0,0 +1,207 @@
+// Runs real webcc apps (app.wasm + app.js) headless under Node and reports
+// command throughput per schema namespace: commands/s, bytes/s and ns per
+// command, split into encode (time in the frame outside webcc_js_flush, i.e.
+// wasm building commands) and decode (time inside it). Browser objects come
+// from ../dispatch/dom_stub.mjs, so the numbers are the two ends of the
+// command buffer and not the browser's drawing.
+//
+//   node headless.mjs <name>:<dist dir> ... [--frames 300] [--warmup 60]
+//        [--click <name>] [--schema ../../schema.def] [--json out.json]
+//
+// Every dist must be built with `webcc --stats`: the per-opcode counters the
+// app keeps for that (include/webcc/core/stats.h) are read back through
+// webcc_stats_ptr after each flush. --click <name> clicks the first
+// clickable element of that scenario once per frame, like bench.mjs --click.
+//
+// The JSON output extends benchmark_results.json (browser, file_sizes,
+// runtime_stats) so runs can be kept and compared next to browser runs.
+
+import fs from 'node:fs';
+import path from 'node:path';
+import vm from 'node:vm';
+import { findClickable, makeGlobals } from '../dispatch/dom_stub.mjs';
+
+const HERE = path.dirname(new URL(import.meta.url).pathname);
+const MB = 1024 * 1024;
+
+// Layout of webcc::stats::Totals (pinned in src/core/stats.cc).
+const COUNTER_SIZE = 16;
+
+function parseArgs(argv) {
+    const opts = { frames: 300, warmup: 60, click: new Set(), schema: path.join(HERE, '../../schema.def'), json: null, verbose: false, scenarios: [] };
+    for (let i = 0; i < argv.length; ++i) {
+        const a = argv[i];
+        if (a === '--frames') opts.frames = parseInt(argv[++i], 10);
+        else if (a === '--warmup') opts.warmup = parseInt(argv[++i], 10);
+        else if (a === '--click') opts.click.add(argv[++i]);
+        else if (a === '--schema') opts.schema = argv[++i];
+        else if (a === '--json') opts.json = argv[++i];
+        else if (a === '--verbose') opts.verbose = true;
+        else {
+            const sep = a.indexOf(':');
+            opts.scenarios.push(sep < 0 ? { name: path.basename(a), dir: a } : { name: a.slice(0, sep), dir: a.slice(sep + 1) });
+        }
+    }
+    return opts;
+}
+
+// Opcode -> namespace, numbered the way load_defs() does: commands from 1 in
+// file order. Built-ins (INTERN, BIND, recording) count as "webcc".
+function loadNamespaces(file) {
+    const ns = new Array(256).fill('webcc');
+    let opcode = 1;
+    for (const line of fs.readFileSync(file, 'utf8').split('\n')) {
+        const f = line.trim().split('|');
+        if (f.length < 3 || f[0].startsWith('#') || f[1] !== 'command') continue;
+        ns[opcode++] = f[0];
+    }
+    return ns;
+}
+
+// Per-opcode byte and command totals, as plain numbers.
+function readTotals(memory, ptr) {
+    const dv = new DataView(memory.buffer, ptr, 256 * COUNTER_SIZE);
+    const commands = new Float64Array(256), bytes = new Float64Array(256);
+    for (let op = 0; op < 256; ++op) {
+        commands[op] = Number(dv.getBigUint64(op * COUNTER_SIZE, true));
+        bytes[op] = Number(dv.getBigUint64(op * COUNTER_SIZE + 8, true));
+    }
+    return { commands, bytes };
+}
+
+async function runScenario({ name, dir }, opts, namespaces) {
+    const g = makeGlobals();
+    if (!opts.verbose) g.console = { ...console, log: () => {}, info: () => {} };
+
+    let instance = null;
+    let frame_decode_ms = 0;
+    g.fetch = async () => ({ arrayBuffer: async () => fs.readFileSync(path.join(dir, 'app.wasm')) });
+    g.WebAssembly = {
+        instantiate: async (bytes, imports) => {
+            const flush = imports.env.webcc_js_flush;
+            imports.env.webcc_js_flush = (ptr, size) => {
+                const t0 = performance.now();
+                flush(ptr, size);
+                frame_decode_ms += performance.now() - t0;
+            };
+            const result = await WebAssembly.instantiate(bytes, imports);
+            instance = result.instance;
+            return result;
+        },
+    };
+
+    const file = path.join(dir, 'app.js');
+    vm.runInContext(fs.readFileSync(file, 'utf8'), vm.createContext(g), { filename: file });
+    for (let i = 0; i < 200 && g.raf.length === 0; ++i) await new Promise((r) => setTimeout(r, 1));
+    if (g.raf.length === 0) throw new Error(`${name}: no main loop was started`);
+    if (!instance.exports.webcc_stats_ptr) throw new Error(`${name}: ${dir} was not built with --stats`);
+
+    const memory = instance.exports.memory;
+    const totals_ptr = instance.exports.webcc_stats_ptr();
+    const per_ns = new Map();
+    const bucket = (ns) => {
+        let b = per_ns.get(ns);
+        if (!b) per_ns.set(ns, (b = { commands: 0, bytes: 0, encode_ms: 0, decode_ms: 0 }));
+        return b;
+    };
+
+    let t = 0;
+    const step = () => {
+        t += 1000 / 60;
+        if (opts.click.has(name)) {
+            const target = findClickable(g.document.body);
+            const onClick = g.document.body.listeners.get('click');
+            if (target && onClick) onClick({ target });
+        }
+        const callbacks = g.raf.splice(0);
+        frame_decode_ms = 0;
+        const t0 = performance.now();
+        for (const cb of callbacks) cb(t);
+        return { ran: callbacks.length > 0, frame_ms: performance.now() - t0, decode_ms: frame_decode_ms };
+    };
+
+    for (let i = 0; i < opts.warmup; ++i) step();
+    let prev = readTotals(memory, totals_ptr);
+    let frames = 0, frame_ms = 0, decode_ms = 0;
+    for (; frames < opts.frames; ++frames) {
+        const f = step();
+        if (!f.ran) break;
+        frame_ms += f.frame_ms;
+        decode_ms += f.decode_ms;
+
+        // Every flush of the frame has been counted by now; share the frame's
+        // encode and decode time between namespaces by the bytes they sent.
+        const now = readTotals(memory, totals_ptr);
+        const sent = new Map();
+        let frame_bytes = 0;
+        for (let op = 0; op < 256; ++op) {
+            const bytes = now.bytes[op] - prev.bytes[op];
+            if (bytes === 0) continue;
+            const b = bucket(namespaces[op]);
+            b.commands += now.commands[op] - prev.commands[op];
+            b.bytes += bytes;
+            sent.set(b, (sent.get(b) || 0) + bytes);
+            frame_bytes += bytes;
+        }
+        for (const [b, bytes] of sent) {
+            b.encode_ms += ((f.frame_ms - f.decode_ms) * bytes) / frame_bytes;
+            b.decode_ms += (f.decode_ms * bytes) / frame_bytes;
+        }
+        prev = now;
+    }
+
+    const rate = (n, ms) => (ms > 0 ? (n * 1000) / ms : 0);
+    const per_command = (ms, n) => (n > 0 ? (ms * 1e6) / n : 0);
+    const ns_stats = {};
+    for (const [ns, b] of [...per_ns].sort((x, y) => y[1].bytes - x[1].bytes)) {
+        const ms = b.encode_ms + b.decode_ms;
+        ns_stats[ns] = {
+            commands: b.commands,
+            bytes: b.bytes,
+            commands_per_sec: rate(b.commands, ms),
+            bytes_per_sec: rate(b.bytes, ms),
+            ns_per_command: per_command(ms, b.commands),
+            encode_ns_per_command: per_command(b.encode_ms, b.commands),
+            decode_ns_per_command: per_command(b.decode_ms, b.commands),
+        };
+    }
+
+    const size = (f) => { try { return fs.statSync(path.join(dir, f)).size; } catch { return 0; } };
+    return {
+        name,
+        wasm_size: size('app.wasm'),
+        js_size: size('app.js'),
+        fps: rate(frames, frame_ms),
+        memory_used_mb: process.memoryUsage().heapUsed / MB,
+        wasm_heap_mb: memory.buffer.byteLength / MB,
+        frames,
+        encode_us_per_frame: frames ? ((frame_ms - decode_ms) * 1000) / frames : 0,
+        decode_us_per_frame: frames ? (decode_ms * 1000) / frames : 0,
+        namespaces: ns_stats,
+    };
+}
+
+const opts = parseArgs(process.argv.slice(2));
+if (opts.scenarios.length === 0) {
+    console.error('usage: node headless.mjs <name>:<dist dir> ... [--frames N] [--warmup N] [--click <name>] [--schema file] [--json out.json]');
+    process.exit(1);
+}
+
+const namespaces = loadNamespaces(opts.schema);
+const report = { browser: `node ${process.version} (headless)`, file_sizes: {}, runtime_stats: {} };
+for (const s of opts.scenarios) {
+    const { wasm_size, js_size, ...r } = await runScenario(s, opts, namespaces);
+    report.file_sizes[`${s.name}_wasm`] = wasm_size;
+    report.file_sizes[`${s.name}_js`] = js_size;
+    report.runtime_stats[s.name] = r;
+
+    console.log(`== ${s.name}: ${r.frames} frames, encode ${r.encode_us_per_frame.toFixed(1)} us/frame, ` +
+        `decode ${r.decode_us_per_frame.toFixed(1)} us/frame`);
+    console.log(`   ${'namespace'.padEnd(10)} ${'commands/s'.padStart(12)} ${'MB/s'.padStart(9)} ` +
+        `${'ns/cmd'.padStart(8)} ${'encode'.padStart(8)} ${'decode'.padStart(8)}`);
+    for (const [ns, n] of Object.entries(r.namespaces)) {
+        console.log(`   ${ns.padEnd(10)} ${n.commands_per_sec.toExponential(2).padStart(12)} ${(n.bytes_per_sec / MB).toFixed(1).padStart(9)} ` +
+            `${n.ns_per_command.toFixed(1).padStart(8)} ${n.encode_ns_per_command.toFixed(1).padStart(8)} ${n.decode_ns_per_command.toFixed(1).padStart(8)}`);
+    }
+}
+if (opts.json) fs.writeFileSync(opts.json, JSON.stringify(report, null, 2) + '\n');
@@ -0,0 +1,22 @@
+#!/bin/bash
+# Builds the benchmark app and a few examples with --stats and reports their
+# per-namespace command throughput under Node (see headless.mjs).
+set -e
+
+cd "$(dirname "$0")"
+ROOT=../..
+FRAMES=${FRAMES:-300}
+
+build() {
+    mkdir -p "dist/$1"
+    "$ROOT/webcc" "$2" --out "dist/$1" --release --stats > /dev/null
+}
+
+build rects "$ROOT/benchmark/webcc/main.cc"
+build canvas "$ROOT/examples/webcc_canvas/example.cc"
+build dom "$ROOT/examples/webcc_dom/example.cc"
+build webgl "$ROOT/examples/webcc_webgl/example.cc"
+build waves "$ROOT/examples/webcc_webgl_waves/example.cc"
+
+node headless.mjs rects:dist/rects canvas:dist/canvas dom:dist/dom webgl:dist/webgl waves:dist/waves \
+    --click dom --frames "$FRAMES" --json dist/headless_results.json
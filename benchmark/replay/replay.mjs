@@ -0,0 +1,163 @@
+// Replays a command-stream capture (webcc --capture) through a generated
+// app.js under Node, against the stand-in DOM and canvas objects of
+// ../dispatch/dom_stub.mjs. No app.wasm is needed: flushes are copied back
+// to the address they were captured at and handed to webcc_js_flush, and
+// return-value calls are re-issued with their string bytes restored, so the
+// decoder sees exactly what the app sent.
+//
+//   node replay.mjs <dist dir> <capture.wccp> [--repeat 20] [--warmup 3] [--json out.json]
+//
+// The dist dir should come from the same schema (and wire format) as the
+// capture; any --dispatch/--release mode works, which makes this a way to
+// compare decoders on a customer's real stream.
+
+import fs from 'node:fs';
+import path from 'node:path';
+import vm from 'node:vm';
+import { makeGlobals } from '../dispatch/dom_stub.mjs';
+
+const FLUSH = 1, CALL = 2;
+
+function parseArgs(argv) {
+    const opts = { repeat: 20, warmup: 3, json: null, positional: [] };
+    for (let i = 0; i < argv.length; ++i) {
+        const a = argv[i];
+        if (a === '--repeat') opts.repeat = parseInt(argv[++i], 10);
+        else if (a === '--warmup') opts.warmup = parseInt(argv[++i], 10);
+        else if (a === '--json') opts.json = argv[++i];
+        else opts.positional.push(a);
+    }
+    return opts;
+}
+
+// Format in src/cli/disasm.h.
+function readCapture(file) {
+    const buf = fs.readFileSync(file);
+    const dv = new DataView(buf.buffer, buf.byteOffset, buf.byteLength);
+    if (buf.toString('latin1', 0, 4) !== 'WCCP' || dv.getUint32(4, true) !== 1) throw new Error(`${file}: not a webcc capture`);
+    const pad = (n) => (n + 3) & ~3;
+    const records = [];
+    let pos = 16;
+    const u32 = () => { const v = dv.getUint32(pos, true); pos += 4; return v; };
+    const bytes = (n) => { const b = new Uint8Array(buf.subarray(pos, pos + n)); pos += pad(n); return b; };
+    while (pos < buf.length) {
+        const kind = buf[pos]; pos += 4;
+        const frame = u32();
+        if (kind === FLUSH) {
+            const ptr = u32();
+            records.push({ kind, frame, ptr, bytes: bytes(u32()) });
+        } else if (kind === CALL) {
+            const name = new TextDecoder().decode(bytes(u32()));
+            const args = [];
+            for (let n = u32(); n > 0; --n) { args.push(dv.getFloat64(pos, true)); pos += 8; }
+            const spans = [];
+            for (let n = u32(); n > 0; --n) { const ptr = u32(); spans.push({ ptr, bytes: bytes(u32()) }); }
+            records.push({ kind, frame, name, args, spans });
+        } else {
+            throw new Error(`${file}: unknown record kind ${kind} at ${pos - 8}`);
+        }
+    }
+    return { wire: dv.getUint32(8, true), records };
+}
+
+async function loadDecoder(dir, memory, reserved) {
+    const g = makeGlobals();
+    let env = null;
+    // Scratch space the runtime expects, placed after the captured addresses.
+    const exports = {
+        memory,
+        main: null,
+        __indirect_function_table: { get: () => () => {} },
+        webcc_event_buffer_ptr: () => reserved,
+        webcc_event_offset_ptr: () => reserved + 65536,
+        webcc_event_buffer_capacity: () => 65536,
+        webcc_scratch_buffer_ptr: () => reserved + 65536 + 128,
+        webcc_frame_end: () => 0,
+        webcc_heap_stats_ptr: () => 0,
+        webcc_stats_ptr: () => reserved + 65536 + 128 + 4096,
+        webcc_stats_decoded: () => {},
+    };
+    g.fetch = async () => ({ arrayBuffer: async () => new ArrayBuffer(0) });
+    g.WebAssembly = { instantiate: async (_bytes, imports) => { env = imports.env; return { instance: { exports } }; } };
+
+    const file = path.join(dir, 'app.js');
+    vm.runInContext(fs.readFileSync(file, 'utf8'), vm.createContext(g), { filename: file });
+    for (let i = 0; i < 50 && env === null; ++i) await new Promise((r) => setTimeout(r, 1));
+    if (env === null) throw new Error(`${file}: the runtime did not start`);
+    // One more tick so run() finishes its setup after instantiation.
+    await new Promise((r) => setTimeout(r, 1));
+    return env;
+}
+
+// One pass over the capture; returns the time spent in flush per frame.
+function replay(env, records, memory) {
+    const per_frame = new Map();
+    let u8 = new Uint8Array(memory.buffer);
+    for (const r of records) {
+        if (r.kind === FLUSH) {
+            u8.set(r.bytes, r.ptr);
+            const t0 = performance.now();
+            env.webcc_js_flush(r.ptr, r.bytes.length);
+            const ms = performance.now() - t0;
+            per_frame.set(r.frame, (per_frame.get(r.frame) || 0) + ms);
+        } else {
+            const fn = env[r.name];
+            if (!fn) continue;
+            for (const s of r.spans) u8.set(s.bytes, s.ptr);
+            fn(...r.args);
+        }
+        if (u8.buffer !== memory.buffer) u8 = new Uint8Array(memory.buffer);
+    }
+    return per_frame;
+}
+
+const opts = parseArgs(process.argv.slice(2));
+if (opts.positional.length !== 2) {
+    console.error('usage: node replay.mjs <dist dir> <capture.wccp> [--repeat N] [--warmup N] [--json out.json]');
+    process.exit(1);
+}
+const [dir, capture_file] = opts.positional;
+const { records } = readCapture(capture_file);
+
+let top = 0;
+for (const r of records) {
+    if (r.kind === FLUSH) top = Math.max(top, r.ptr + r.bytes.length);
+    else for (const s of r.spans) top = Math.max(top, s.ptr + s.bytes.length);
+}
+const reserved = (top + 65535) & ~65535;
+const memory = new WebAssembly.Memory({ initial: reserved / 65536 + 2 });
+const env = await loadDecoder(dir, memory, reserved);
+
+const flushes = records.filter((r) => r.kind === FLUSH);
+const bytes = flushes.reduce((n, r) => n + r.bytes.length, 0);
+for (let i = 0; i < opts.warmup; ++i) replay(env, records, memory);
+const frame_ms = [];
+let total_ms = 0;
+for (let i = 0; i < opts.repeat; ++i) {
+    for (const ms of replay(env, records, memory).values()) {
+        frame_ms.push(ms);
+        total_ms += ms;
+    }
+}
+frame_ms.sort((a, b) => a - b);
+const pct = (p) => frame_ms.length ? frame_ms[Math.min(frame_ms.length - 1, Math.floor(p * frame_ms.length))] * 1000 : 0;
+const frames = new Set(flushes.map((r) => r.frame)).size;
+
+const result = {
+    capture: capture_file,
+    decoder: dir,
+    frames,
+    flushes: flushes.length,
+    calls: records.length - flushes.length,
+    bytes,
+    repeat: opts.repeat,
+    us_per_frame: frame_ms.length ? (total_ms * 1000) / frame_ms.length : 0,
+    p50_us: pct(0.5),
+    p95_us: pct(0.95),
+    max_us: pct(1),
+    ns_per_byte: bytes ? (total_ms * 1e6) / (bytes * opts.repeat) : 0,
+};
+console.log(`${frames} frames, ${flushes.length} flushes, ${result.calls} calls, ${bytes} bytes (x${opts.repeat})`);
+console.log(`flush per frame: ${result.us_per_frame.toFixed(2)} us avg, ${result.p50_us.toFixed(2)} p50, ` +
+    `${result.p95_us.toFixed(2)} p95, ${result.max_us.toFixed(2)} max; ${result.ns_per_byte.toFixed(2)} ns/B`);
+if (opts.json) fs.writeFileSync(opts.json, JSON.stringify(result, null, 2) + '\n');
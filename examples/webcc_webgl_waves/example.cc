@@ -3,6 +3,7 @@
 #include "webcc/dom.h"
 #include "webcc/system.h"
 #include "webcc/core/math.h"
+#include "webcc/core/display_list.h"
 
 // --- GL Constants ---
 constexpr uint32_t GL_TRIANGLES = 0x0004;
@@ -97,22 +98,31 @@ webcc::WebGLBuffer vbo;
 webcc::WebGLUniform uTimeLoc;
 float total_time = 0.0f;
 
+webcc::display_list frame_setup;
+
 void update(float time_ms) {
     total_time = time_ms / 1000.0f;
 
-    webcc::webgl::viewport(gl, 0, 0, 1920, 1080);
-    webcc::webgl::clear_color(gl, 0.02f, 0.02f, 0.05f, 1.0f);
-    webcc::webgl::clear(gl, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    webcc::webgl::enable(gl, GL_DEPTH_TEST);
-    webcc::webgl::use_program(gl, prog);
-    
+    // The per-frame GL state never changes: record it on the first frame and
+    // replay it afterwards.
+    if (!frame_setup.is_valid()) {
+        frame_setup = webcc::begin_record();
+        webcc::webgl::viewport(gl, 0, 0, 1920, 1080);
+        webcc::webgl::clear_color(gl, 0.02f, 0.02f, 0.05f, 1.0f);
+        webcc::webgl::clear(gl, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        webcc::webgl::enable(gl, GL_DEPTH_TEST);
+        webcc::webgl::use_program(gl, prog);
+        webcc::webgl::bind_buffer(gl, GL_ARRAY_BUFFER, vbo);
+        webcc::webgl::enable_vertex_attrib_array(gl, 0);
+        webcc::webgl::vertex_attrib_pointer(gl, 0, 3, GL_FLOAT, 0, 0, 0);
+        webcc::end_record();
+    } else {
+        webcc::replay(frame_setup);
+    }
+
     // Pass time to shader
     webcc::webgl::uniform_1f(gl, uTimeLoc, total_time);
 
-    webcc::webgl::bind_buffer(gl, GL_ARRAY_BUFFER, vbo);
-    webcc::webgl::enable_vertex_attrib_array(gl, 0);
-    webcc::webgl::vertex_attrib_pointer(gl, 0, 3, GL_FLOAT, 0, 0, 0);
-
     webcc::webgl::draw_arrays(gl, GL_TRIANGLES, 0, vertex_count);
     webcc::flush();
 }
@@ -4,10 +4,10 @@
 
 // WebCC heap allocator.
 //
-// A boundary-tag free-list allocator: small fixed overhead per block, with
-// splitting on allocation and coalescing on free so the heap can shrink back
-// down instead of only ever growing. Tuned for the WebCC workload (lots of
-// growing vector/string buffers churning malloc+free).
+// A boundary-tag allocator with two-level segregated free lists (TLSF): small
+// fixed overhead per block, with splitting on allocation and coalescing on free
+// so the heap can shrink back down instead of only ever growing. Tuned for the
+// WebCC workload (lots of growing vector/string buffers churning malloc+free).
 //
 // Layout of every block:
 //
@@ -18,7 +18,13 @@
 // allocator. Blocks are threaded in physical (address) order via `prev_phys`,
 // which lets free() find and merge neighbours in O(1). Free blocks additionally
 // store their free-list links inside their (otherwise unused) payload, so the
-// free list costs no extra space.
+// free lists cost no extra space.
+//
+// Free blocks are binned by size: a first level per power of two, split into
+// 16 linear second-level classes (sizes below 128 get one class per 8 bytes).
+// A bitmap per level records which lists are non-empty, so malloc finds a
+// block that is guaranteed to fit with two count-trailing-zeros instead of
+// walking a list. That keeps allocation O(1) however fragmented the heap gets.
 //
 // The WASM-specific bits (linear memory growth, `__heap_base`) live behind a
 // small backend so the allocator also compiles and runs host-native for tests.
@@ -76,7 +82,51 @@ namespace webcc
         // --- Allocator state ---------------------------------------------------
         inline uintptr_t heap_ptr = align_up(backend_base()); // top of the bump region
         inline BlockHeader *last_block = nullptr;             // block bordering the wilderness
-        inline BlockHeader *free_head = nullptr;              // head of the free list
+
+        // --- Segregated free lists ---------------------------------------------
+        // Sizes below SMALL_BLOCK map to first level 0 with a class per ALIGN
+        // bytes; above that, first level = log2(size) - FL_SHIFT + 1 and the
+        // SL_LOG2 bits below the top one pick the second level. FL_COUNT levels
+        // cover blocks up to 4GB, the whole wasm32 address space.
+        constexpr unsigned SL_LOG2 = 4;
+        constexpr unsigned SL_COUNT = 1u << SL_LOG2;
+        constexpr unsigned FL_SHIFT = SL_LOG2 + 3; // log2(SL_COUNT * ALIGN)
+        constexpr size_t SMALL_BLOCK = (size_t)1 << FL_SHIFT;
+        constexpr unsigned FL_COUNT = 32 - FL_SHIFT + 1;
+
+        inline uint32_t fl_bitmap = 0;                           // bit f: some list in level f is non-empty
+        inline uint32_t sl_bitmap[FL_COUNT] = {};                // bit s: free_lists[f][s] is non-empty
+        inline BlockHeader *free_lists[FL_COUNT][SL_COUNT] = {}; // list heads per size class
+    } // namespace detail
+
+    // Heap counters, kept up to date by every malloc/free (a few adds each) so
+    // reading them is O(1) in any build. heap_stats() fills in the derived
+    // fields; app.js reads the same struct for webcc_heap() (the layout is
+    // pinned in src/core/heap_stats.cc). Sizes are wasm32 byte counts.
+    struct HeapStats
+    {
+        uint64_t allocs;            // successful malloc calls (a moving realloc counts one)
+        uint64_t frees;             // free calls with a non-null pointer
+        uint32_t live_bytes;        // payload bytes in allocated blocks
+        uint32_t peak_live_bytes;
+        uint32_t free_blocks;       // blocks on the free lists
+        uint32_t free_bytes;        // their payload bytes
+        uint32_t largest_free;      // lower bound on the biggest free list block
+        uint32_t heap_bytes;        // span from the heap base to the bump pointer
+        uint32_t committed_bytes;   // span from the heap base to the end of memory
+        uint32_t grows;             // memory.grow calls
+        uint32_t grown_bytes;
+        uint32_t frame_allocs;      // allocs since the last frame ended
+        uint32_t frame_alloc_budget;
+        uint32_t frames_over_budget;
+        // Successful mallocs by requested size: [0] under 128 bytes, then
+        // [k] in [64 << k, 128 << k).
+        uint32_t size_classes[detail::FL_COUNT];
+    };
+
+    namespace detail
+    {
+        inline HeapStats g_heap_stats = {};
 
         // --- Block helpers -----------------------------------------------------
         inline size_t blk_size(BlockHeader *b) { return b->size_flags & ~(size_t)(ALIGN - 1); }
@@ -103,42 +153,138 @@ namespace webcc
         };
         inline FreeLinks *links(BlockHeader *b) { return (FreeLinks *)payload(b); }
 
+        inline unsigned log2_floor(size_t n)
+        {
+            if constexpr (sizeof(size_t) == 8)
+                return 63u - (unsigned)__builtin_clzll(n);
+            else
+                return 31u - (unsigned)__builtin_clz((unsigned)n);
+        }
+
+        // Size class holding blocks of exactly `size` bytes. Clamping the
+        // log2 to FL_SHIFT makes the small sizes fall out of the same formula,
+        // so there is no branch to mispredict on the hot path.
+        inline void mapping_insert(size_t size, unsigned &fl, unsigned &sl)
+        {
+            unsigned top = log2_floor(size | SMALL_BLOCK);
+            unsigned idx = ((top - FL_SHIFT) << SL_LOG2) + (unsigned)(size >> (top - SL_LOG2));
+            fl = idx >> SL_LOG2;
+            sl = idx & (SL_COUNT - 1);
+        }
+
+        // Size class to start searching from for a request of `size` bytes:
+        // the request is rounded up to the next class boundary, so any block in
+        // that class or above fits without checking its size. Returns false if
+        // the request is larger than any class that can round up.
+        inline bool mapping_search(size_t size, unsigned &fl, unsigned &sl)
+        {
+            if (size >= (size_t)1 << 31)
+                return false;
+            size += ((size_t)1 << (log2_floor(size | SMALL_BLOCK) - SL_LOG2)) - 1;
+            mapping_insert(size, fl, sl);
+            return true;
+        }
+
+        // First non-empty list at or above class (fl, sl), or null.
+        inline BlockHeader *find_suitable(unsigned fl, unsigned sl)
+        {
+            uint32_t sl_map = sl_bitmap[fl] & (~0u << sl);
+            if (!sl_map)
+            {
+                uint32_t fl_map = fl_bitmap & (~0u << (fl + 1));
+                if (!fl_map)
+                    return nullptr;
+                fl = (unsigned)__builtin_ctz(fl_map);
+                sl_map = sl_bitmap[fl];
+            }
+            return free_lists[fl][__builtin_ctz(sl_map)];
+        }
+
         inline void fl_insert(BlockHeader *b)
         {
+            unsigned fl, sl;
+            mapping_insert(blk_size(b), fl, sl);
+            BlockHeader *head = free_lists[fl][sl];
             FreeLinks *l = links(b);
             l->prev = nullptr;
-            l->next = free_head;
-            if (free_head)
-                links(free_head)->prev = b;
-            free_head = b;
+            l->next = head;
+            if (head)
+                links(head)->prev = b;
+            free_lists[fl][sl] = b;
+            fl_bitmap |= 1u << fl;
+            sl_bitmap[fl] |= 1u << sl;
             set_blk(b, blk_size(b), true);
+            g_heap_stats.free_blocks++;
+            g_heap_stats.free_bytes += (uint32_t)blk_size(b);
         }
 
         inline void fl_remove(BlockHeader *b)
         {
             FreeLinks *l = links(b);
+            if (l->next)
+                links(l->next)->prev = l->prev;
             if (l->prev)
+            {
                 links(l->prev)->next = l->next;
+            }
             else
-                free_head = l->next;
-            if (l->next)
-                links(l->next)->prev = l->prev;
+            {
+                // Only the head is referenced from the index.
+                unsigned fl, sl;
+                mapping_insert(blk_size(b), fl, sl);
+                free_lists[fl][sl] = l->next;
+                if (!l->next)
+                {
+                    sl_bitmap[fl] &= ~(1u << sl);
+                    if (!sl_bitmap[fl])
+                        fl_bitmap &= ~(1u << fl);
+                }
+            }
             set_blk(b, blk_size(b), false);
+            g_heap_stats.free_blocks--;
+            g_heap_stats.free_bytes -= (uint32_t)blk_size(b);
         }
 
         inline bool ensure_capacity(uintptr_t new_top)
         {
             if (new_top <= backend_end())
                 return true;
-            return backend_grow(new_top - backend_end());
+            uintptr_t end = backend_end();
+            if (!backend_grow(new_top - end))
+                return false;
+            g_heap_stats.grows++;
+            g_heap_stats.grown_bytes += (uint32_t)(backend_end() - end);
+            return true;
         }
 
+        // Accounting at the public entry points. Splits and merges inside
+        // the allocator don't count as allocations or frees.
+        inline void *note_alloc(void *p, size_t request)
+        {
+            HeapStats &st = g_heap_stats;
+            st.allocs++;
+            st.frame_allocs++;
+            st.live_bytes += (uint32_t)blk_size(hdr_of(p));
+            if (st.live_bytes > st.peak_live_bytes)
+                st.peak_live_bytes = st.live_bytes;
+            unsigned fl, sl;
+            mapping_insert(request, fl, sl);
+            st.size_classes[fl < FL_COUNT ? fl : FL_COUNT - 1]++;
+            return p;
+        }
+
+        inline void note_resize(BlockHeader *b, size_t old_size)
+        {
+            HeapStats &st = g_heap_stats;
+            st.live_bytes += (uint32_t)blk_size(b) - (uint32_t)old_size;
+            if (st.live_bytes > st.peak_live_bytes)
+                st.peak_live_bytes = st.live_bytes;
+        }
+
+        // One memory.copy under -mbulk-memory.
         inline void mem_copy(void *dst, const void *src, size_t n)
         {
-            uint8_t *d = (uint8_t *)dst;
-            const uint8_t *s = (const uint8_t *)src;
-            while (n--)
-                *d++ = *s++;
+            __builtin_memcpy(dst, src, n);
         }
 
         // Forward declaration: place() releases its split-off tail through free().
@@ -214,17 +360,31 @@ namespace webcc
         if (size == 0 || size > SIZE_MAX - HEADER_SIZE - MIN_PAYLOAD)
             return nullptr;
 
+        size_t request = size;
         size = align_up(size);
         if (size < MIN_PAYLOAD)
             size = MIN_PAYLOAD;
 
-        // 1. First-fit search of the free list.
-        for (BlockHeader *b = free_head; b; b = links(b)->next)
+        // 1. Good-fit from the segregated lists: a block from the rounded-up
+        //    class always fits; failing that, the head of the request's own
+        //    class may still be large enough.
+        BlockHeader *b = nullptr;
+        if (fl_bitmap)
         {
-            if (blk_size(b) >= size)
+            unsigned fl, sl;
+            if (mapping_search(size, fl, sl))
+                b = find_suitable(fl, sl);
+            if (!b && size >= SMALL_BLOCK)
+            {
+                mapping_insert(size, fl, sl);
+                b = fl < FL_COUNT ? free_lists[fl][sl] : nullptr;
+                if (b && blk_size(b) < size)
+                    b = nullptr;
+            }
+            if (b)
             {
                 fl_remove(b);
-                return place(b, size);
+                return note_alloc(place(b, size), request);
             }
         }
 
@@ -234,12 +394,12 @@ namespace webcc
         if (!ensure_capacity(new_top))
             return nullptr;
 
-        BlockHeader *b = (BlockHeader *)cur_top;
+        b = (BlockHeader *)cur_top;
         b->prev_phys = last_block;
         set_blk(b, size, false);
         heap_ptr = new_top;
         last_block = b;
-        return payload(b);
+        return note_alloc(payload(b), request);
     }
 
     namespace detail
@@ -291,7 +451,15 @@ namespace webcc
         }
     } // namespace detail
 
-    inline void free(void *ptr) { detail::heap_free(ptr); }
+    inline void free(void *ptr)
+    {
+        using namespace detail;
+        if (!ptr)
+            return;
+        g_heap_stats.frees++;
+        g_heap_stats.live_bytes -= (uint32_t)blk_size(hdr_of(ptr));
+        heap_free(ptr);
+    }
 
     inline void *realloc(void *ptr, size_t size)
     {
@@ -315,11 +483,18 @@ namespace webcc
 
         // Shrinking (or same size): trim in place, releasing the tail.
         if (cur >= size)
-            return place(b, size);
+        {
+            place(b, size);
+            note_resize(b, cur);
+            return ptr;
+        }
 
         // Growing: try to do it in place (no copy) first.
         if (grow_inplace(b, size))
+        {
+            note_resize(b, cur);
             return ptr;
+        }
 
         // Fall back to allocate + copy + free.
         void *np = malloc(size);
@@ -344,29 +519,55 @@ namespace webcc
         if (size < MIN_PAYLOAD)
             size = MIN_PAYLOAD;
         BlockHeader *b = hdr_of(ptr);
-        if (blk_size(b) >= size)
+        size_t cur = blk_size(b);
+        if (cur >= size)
             return true; // already big enough
-        return grow_inplace(b, size);
+        if (!grow_inplace(b, size))
+            return false;
+        note_resize(b, cur);
+        return true;
+    }
+
+    // The heap counters, with the derived fields refreshed.
+    inline const HeapStats &heap_stats()
+    {
+        using namespace detail;
+        HeapStats &st = g_heap_stats;
+        uintptr_t base = align_up(backend_base());
+        st.heap_bytes = (uint32_t)(heap_ptr - base);
+        st.committed_bytes = (uint32_t)(backend_end() - base);
+        st.largest_free = 0;
+        if (fl_bitmap)
+        {
+            // Smallest size in the highest non-empty class.
+            unsigned fl = 31 - (unsigned)__builtin_clz(fl_bitmap);
+            unsigned sl = 31 - (unsigned)__builtin_clz(sl_bitmap[fl]);
+            st.largest_free = fl == 0 ? sl * (uint32_t)ALIGN : (SL_COUNT | sl) << (fl - 1 + FL_SHIFT - SL_LOG2);
+        }
+        return st;
+    }
+
+    namespace detail
+    {
+        inline void (*g_frame_budget_hook)(uint32_t allocs) = nullptr;
+    }
+
+    // Debug guard for allocation-free frames: once a main-loop frame has made
+    // more than `max_allocs` heap allocations, the frame end reports it, to
+    // `hook` if given and otherwise as a console warning from app.js. 0 turns
+    // the guard off. HeapStats::frames_over_budget counts the offenders.
+    inline void set_frame_alloc_budget(uint32_t max_allocs, void (*hook)(uint32_t allocs) = nullptr)
+    {
+        detail::g_heap_stats.frame_alloc_budget = max_allocs;
+        detail::g_frame_budget_hook = hook;
     }
 
     namespace detail
     {
         // Introspection helpers (used by tests; tree-shaken when unused).
         inline size_t heap_used() { return (size_t)(heap_ptr - align_up(backend_base())); }
-        inline size_t free_block_count()
-        {
-            size_t n = 0;
-            for (BlockHeader *b = free_head; b; b = links(b)->next)
-                ++n;
-            return n;
-        }
-        inline size_t free_bytes()
-        {
-            size_t s = 0;
-            for (BlockHeader *b = free_head; b; b = links(b)->next)
-                s += blk_size(b);
-            return s;
-        }
+        inline size_t free_block_count() { return g_heap_stats.free_blocks; }
+        inline size_t free_bytes() { return g_heap_stats.free_bytes; }
 #if !defined(__wasm__)
         // Reset all allocator state. Host/test builds only.
         inline void heap_reset()
@@ -374,7 +575,14 @@ namespace webcc
             g_host_committed = 0;
             heap_ptr = align_up(backend_base());
             last_block = nullptr;
-            free_head = nullptr;
+            g_heap_stats = {};
+            fl_bitmap = 0;
+            for (unsigned f = 0; f < FL_COUNT; ++f)
+            {
+                sl_bitmap[f] = 0;
+                for (unsigned s = 0; s < SL_COUNT; ++s)
+                    free_lists[f][s] = nullptr;
+            }
         }
 #endif
     } // namespace detail
@@ -0,0 +1,63 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "wire.h"
+#include "../../../src/core/command_buffer.h"
+
+// Encoding helpers for the runtime's built-in commands (opcodes from
+// OP_BUILTIN_FIRST up), shared by intern.h and display_list.h. The opcode is
+// a word in the v1 wire format and a byte in the compact one.
+
+namespace webcc::detail
+{
+    constexpr size_t OPCODE_SIZE = WIRE_VERSION >= 2 ? 1 : 4;
+
+    inline void put_opcode(CommandCursor &c, uint8_t op)
+    {
+        if constexpr (WIRE_VERSION >= 2)
+            c.u8(op);
+        else
+            c.u32(op);
+    }
+
+    // [op] or [op][u32 arg]
+    inline void emit_builtin(uint8_t op)
+    {
+        if (CommandCursor c = CommandBuffer::reserve(OPCODE_SIZE))
+        {
+            put_opcode(c, op);
+            CommandBuffer::commit(c);
+        }
+    }
+
+    inline void emit_builtin(uint8_t op, uint32_t arg)
+    {
+        if (CommandCursor c = CommandBuffer::reserve(OPCODE_SIZE + 4))
+        {
+            put_opcode(c, op);
+            c.u32(arg);
+            CommandBuffer::commit(c);
+        }
+    }
+
+    // Same, for built-ins that CommandBuffer::reset() must not drop.
+    inline void emit_kept_builtin(uint8_t op)
+    {
+        if (CommandCursor c = CommandBuffer::reserve(OPCODE_SIZE))
+        {
+            put_opcode(c, op);
+            CommandBuffer::commit_kept(c);
+        }
+    }
+
+    inline void emit_kept_builtin(uint8_t op, uint32_t arg)
+    {
+        if (CommandCursor c = CommandBuffer::reserve(OPCODE_SIZE + 4))
+        {
+            put_opcode(c, op);
+            c.u32(arg);
+            CommandBuffer::commit_kept(c);
+        }
+    }
+
+} // namespace webcc::detail
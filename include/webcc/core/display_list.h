@@ -0,0 +1,91 @@
+#pragma once
+#include <stdint.h>
+#include "handle.h"
+#include "builtin.h"
+
+// Retained display lists.
+//
+// Commands issued between begin_record() and end_record() run as usual and
+// are also kept by the JS runtime, as a copy of their encoded bytes. replay()
+// then runs that copy again from a single command: nothing is re-encoded in
+// C++ and nothing crosses the boundary but the REPLAY itself.
+//
+//     static webcc::display_list hud;
+//     if (!hud.is_valid()) {
+//         hud = webcc::begin_record();
+//         draw_hud_chrome();
+//         webcc::end_record();
+//     } else {
+//         webcc::replay(hud);
+//     }
+//
+// A list holds commands, not values: handles are looked up and pointer params
+// dereferenced each time it is replayed. Only buffered (void) commands are
+// recorded; calls that return a value run immediately and are not part of the
+// list. Records do not nest, and may span flushes. CommandBuffer::reset()
+// drops the commands recorded so far but keeps the record open (or closed),
+// so JS and C++ agree on it.
+
+namespace webcc
+{
+    struct display_list_tag {};
+    using display_list = typed_handle<display_list_tag>;
+
+    namespace detail
+    {
+        inline int32_t next_display_list = 0;
+        inline bool recording = false;
+    }
+
+    // Feature marker for the display-list built-ins (see emit_headers): only
+    // when one of these functions is linked in does app.js carry the recorder.
+#if defined(__wasm__)
+    extern "C" __attribute__((import_module("w"), import_name("253"))) void __webcc_m_253(void);
+#else
+    extern "C" void __webcc_m_253(void);
+#endif
+
+    // Start recording into a new list. Returns an invalid handle if a record
+    // is already open.
+    inline display_list begin_record()
+    {
+        [[maybe_unused]] static void (*const __webcc_keep)(void) __attribute__((used)) = &__webcc_m_253;
+        if (detail::recording)
+            return display_list();
+        display_list list(detail::next_display_list++);
+        detail::emit_kept_builtin(OP_BEGIN_RECORD, (uint32_t)list.value);
+        detail::recording = true;
+        // The list must not depend on bind registers set before it.
+        detail::unbind_all();
+        return list;
+    }
+
+    inline void end_record()
+    {
+        [[maybe_unused]] static void (*const __webcc_keep)(void) __attribute__((used)) = &__webcc_m_253;
+        if (!detail::recording)
+            return;
+        detail::emit_kept_builtin(OP_END_RECORD);
+        detail::recording = false;
+        detail::unbind_all();
+    }
+
+    inline void replay(display_list list)
+    {
+        [[maybe_unused]] static void (*const __webcc_keep)(void) __attribute__((used)) = &__webcc_m_253;
+        if (!list.is_valid())
+            return;
+        detail::emit_builtin(OP_REPLAY, (uint32_t)list.value);
+        // The replayed commands leave the bind registers in an unknown state.
+        detail::unbind_all();
+    }
+
+    // Free the JS-side copy. The handle must not be replayed afterwards.
+    inline void discard(display_list list)
+    {
+        [[maybe_unused]] static void (*const __webcc_keep)(void) __attribute__((used)) = &__webcc_m_253;
+        if (list.is_valid())
+            detail::emit_builtin(OP_DISCARD_LIST, (uint32_t)list.value);
+    }
+
+} // namespace webcc
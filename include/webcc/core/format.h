@@ -1,6 +1,7 @@
 #pragma once
 #include <stdint.h>
 #include <stddef.h>
+#include "frame_arena.h"
 
 namespace webcc {
 
@@ -283,6 +284,7 @@ private:
     size_t m_pos = 0;
     size_t m_capacity = StackSize;
     bool m_on_heap = false;
+    bool m_frame = detail::in_frame_scope(); // spill into the frame arena
 
     char* buffer() { return m_on_heap ? m_heap : m_stack; }
     const char* buffer() const { return m_on_heap ? m_heap : m_stack; }
@@ -296,13 +298,13 @@ private:
 
         if (m_on_heap) {
             // Already on the heap: realloc grows in place when possible.
-            char* new_data = (char*)webcc::realloc(m_heap, new_cap);
+            char* new_data = (char*)detail::scoped_realloc(m_heap, m_pos + 1, new_cap);
             if (!new_data) return; // keep the old buffer on failure
             m_heap = new_data;
         } else {
             // First overflow off the stack buffer: must copy out of it (the
             // stack storage isn't owned by the allocator, so realloc can't move it).
-            char* new_data = (char*)webcc::malloc(new_cap);
+            char* new_data = (char*)detail::scoped_malloc(new_cap, m_frame);
             if (!new_data) return;
             for (size_t i = 0; i < m_pos; ++i) new_data[i] = m_stack[i];
             m_heap = new_data;
@@ -314,7 +316,7 @@ private:
 
 public:
     hybrid_formatter() { m_stack[0] = '\0'; }
-    ~hybrid_formatter() { if (m_on_heap && m_heap) webcc::free(m_heap); }
+    ~hybrid_formatter() { if (m_on_heap && m_heap) detail::scoped_free(m_heap); }
     
     // No copy
     hybrid_formatter(const hybrid_formatter&) = delete;
@@ -325,7 +327,8 @@ public:
     bool on_heap() const { return m_on_heap; }
 
     // Release heap buffer (only valid if on_heap() is true)
-    // Returns nullptr if still on stack
+    // Returns nullptr if still on stack. Inside a frame_scope the buffer may
+    // be frame memory, so free it with detail::scoped_free.
     char* release() {
         if (!m_on_heap) return nullptr;
         char* ptr = m_heap;
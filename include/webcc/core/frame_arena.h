@@ -0,0 +1,212 @@
+#pragma once
+#include "allocator.h"
+
+// Frame arena: bump allocation for per-frame temporaries.
+//
+// A frame_arena hands out 8-aligned slices of one block by bumping an offset.
+// Nothing is freed individually; mark() and reset() roll the whole arena back
+// at once. That makes a temporary string or formatter spill a pointer bump
+// instead of a trip through the general heap, and keeps those short-lived
+// blocks from fragmenting it.
+//
+// webcc::frame_memory() is the arena the runtime manages. Inside a
+// webcc::frame_scope, string, vector and hybrid_formatter take their buffers
+// from it, and the JS runtime resets it after every main-loop callback
+// returns:
+//
+//     void update(float t) {
+//         webcc::frame_scope scope;
+//         webcc::string label = webcc::string::concat("fps: ", fps);
+//         ...
+//     } // label's bytes are reclaimed when the frame ends
+//
+// Whether an object may use the arena is decided when it is constructed: one
+// created inside a scope takes all its buffers from the arena and must not
+// outlive the frame; one created outside (a global, a member of a long-lived
+// object) stays on the heap even when it is filled or assigned inside a
+// scope, copying out any frame memory it is handed. The elements a container
+// constructs count as created where the container was: a global
+// vector<string> filled inside a scope keeps its strings on the heap too.
+
+namespace webcc
+{
+    // Arenas are meant to live for the whole app, so the class stays trivially
+    // destructible (a global one costs no exit-time destructor); call
+    // release() to hand a block back early.
+    class frame_arena
+    {
+    public:
+        frame_arena() = default;
+        explicit frame_arena(size_t capacity) { reserve(capacity); }
+
+        frame_arena(const frame_arena &) = delete;
+        frame_arena &operator=(const frame_arena &) = delete;
+
+        // Replace the backing block with one of `capacity` bytes. Everything
+        // allocated from the old block is dropped. Returns false (keeping the
+        // old block) if the heap is out of memory.
+        bool reserve(size_t capacity)
+        {
+            capacity = detail::align_up(capacity);
+            uint8_t *base = (uint8_t *)webcc::malloc(capacity);
+            if (!base)
+                return false;
+            webcc::free(m_base);
+            m_base = base;
+            m_capacity = capacity;
+            m_top = 0;
+            m_last = 0;
+            return true;
+        }
+
+        void release()
+        {
+            webcc::free(m_base);
+            m_base = nullptr;
+            m_capacity = 0;
+            m_top = 0;
+            m_last = 0;
+        }
+
+        // `size` bytes, 8-aligned, or null when the arena is full.
+        void *alloc(size_t size)
+        {
+            size = detail::align_up(size);
+            if (size > m_capacity - m_top)
+                return nullptr;
+            m_last = m_top;
+            m_top += size;
+            return m_base + m_last;
+        }
+
+        // Extend `p` to `size` bytes without moving it. Only the most recent
+        // allocation can grow, and only while the arena has room.
+        bool try_grow(void *p, size_t size)
+        {
+            if ((uint8_t *)p != m_base + m_last || m_last == m_top)
+                return false;
+            size = detail::align_up(size);
+            if (size > m_capacity - m_last)
+                return false;
+            if (m_last + size > m_top)
+                m_top = m_last + size;
+            return true;
+        }
+
+        bool owns(const void *p) const { return (uintptr_t)p - (uintptr_t)m_base < m_capacity; }
+
+        // Roll back to a previous mark() (everything by default).
+        size_t mark() const { return m_top; }
+        void reset(size_t mark = 0)
+        {
+            m_top = mark;
+            m_last = mark;
+        }
+
+        size_t used() const { return m_top; }
+        size_t capacity() const { return m_capacity; }
+
+    private:
+        uint8_t *m_base = nullptr;
+        size_t m_capacity = 0;
+        size_t m_top = 0;
+        size_t m_last = 0; // offset of the newest allocation (== m_top once reset)
+    };
+
+    namespace detail
+    {
+        constexpr size_t FRAME_ARENA_DEFAULT = 64 * 1024;
+
+        inline frame_arena g_frame_arena;
+        inline int g_frame_scopes = 0;
+
+        inline bool frame_owned(const void *p) { return g_frame_arena.owns(p); }
+
+        // Captured by string, vector and hybrid_formatter at construction:
+        // true if the object may take frame memory.
+        inline bool in_frame_scope() { return g_frame_scopes > 0; }
+
+        // Hides the enclosing scopes while a heap container constructs its
+        // elements, so they take the container's domain rather than the
+        // caller's. Does nothing when `heap` is false.
+        class heap_scope
+        {
+            int m_saved = g_frame_scopes;
+
+        public:
+            explicit heap_scope(bool heap = true)
+            {
+                if (heap)
+                    g_frame_scopes = 0;
+            }
+            ~heap_scope() { g_frame_scopes = m_saved; }
+
+            heap_scope(const heap_scope &) = delete;
+            heap_scope &operator=(const heap_scope &) = delete;
+        };
+
+        // Allocation entry points for those types. `frame` is the owner's
+        // in_frame_scope() from construction; a request the arena cannot fit
+        // goes to the heap.
+        inline void *scoped_malloc(size_t size, bool frame)
+        {
+            if (frame)
+            {
+                if (!g_frame_arena.capacity())
+                    g_frame_arena.reserve(FRAME_ARENA_DEFAULT);
+                if (void *p = g_frame_arena.alloc(size))
+                    return p;
+            }
+            return webcc::malloc(size);
+        }
+
+        inline void scoped_free(void *p)
+        {
+            if (!frame_owned(p))
+                webcc::free(p);
+        }
+
+        inline bool scoped_try_grow_inplace(void *p, size_t size)
+        {
+            return frame_owned(p) ? g_frame_arena.try_grow(p, size) : webcc::try_grow_inplace(p, size);
+        }
+
+        // realloc for buffers from scoped_malloc. `used` is how many bytes of
+        // `p` to keep; arena blocks do not record their own size. A heap
+        // block stays on the heap, an arena block moves within the arena.
+        inline void *scoped_realloc(void *p, size_t used, size_t size)
+        {
+            if (!frame_owned(p))
+                return webcc::realloc(p, size);
+            if (g_frame_arena.try_grow(p, size))
+                return p;
+            void *np = scoped_malloc(size, true);
+            if (np)
+                mem_copy(np, p, used < size ? used : size);
+            return np;
+        }
+    } // namespace detail
+
+    // The arena behind frame_scope, reset by the runtime after each main-loop
+    // callback. Its 64KB block is allocated on first use; call reserve() up
+    // front to size it for the app.
+    inline frame_arena &frame_memory() { return detail::g_frame_arena; }
+
+    // Strings, vectors and hybrid_formatters constructed while it is alive
+    // allocate from frame_memory(). Scopes nest.
+    class frame_scope
+    {
+    public:
+        frame_scope() { ++detail::g_frame_scopes; }
+        ~frame_scope() { --detail::g_frame_scopes; }
+
+        frame_scope(const frame_scope &) = delete;
+        frame_scope &operator=(const frame_scope &) = delete;
+    };
+
+    // Called by the JS runtime once the main-loop callback returns. Resets
+    // frame_memory() and checks the frame's allocations against
+    // set_frame_alloc_budget(); returns the count for app.js to warn about
+    // when it is over budget and no hook was set, otherwise 0.
+    extern "C" uint32_t webcc_frame_end();
+} // namespace webcc
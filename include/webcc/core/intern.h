@@ -0,0 +1,88 @@
+#pragma once
+#include <stdint.h>
+#include "string_view.h"
+#include "string.h"
+#include "builtin.h"
+
+// Interned strings.
+//
+// intern() sends a string to the JS runtime once, in an INTERN built-in
+// command, and returns a small id. The JS side decodes it a single time and
+// keeps it in a table indexed by id. Passing the id wherever a schema
+// `string` param is expected then costs 4 bytes in the command buffer and no
+// TextDecoder call:
+//
+//     static const webcc::interned style = webcc::intern("style");
+//     webcc::dom::set_attribute(el, style, "color: red");
+//
+// Every call registers a new id, so intern once and keep the result.
+
+namespace webcc
+{
+    // Marks the length field of a string param as carrying an id instead.
+    constexpr uint32_t INTERNED_BIT = 0x80000000u;
+
+    class interned
+    {
+        uint32_t m_id;
+
+    public:
+        constexpr explicit interned(uint32_t id) : m_id(id) {}
+        constexpr uint32_t id() const { return m_id; }
+    };
+
+    // Parameter type of the `string` params of generated void commands: either
+    // bytes to copy into the command buffer, or an interned id.
+    class string_arg
+    {
+        const char *m_data;
+        uint32_t m_len;
+        uint32_t m_ref; // INTERNED_BIT | id, or 0 for plain bytes
+
+    public:
+        string_arg(const char *s) : string_arg(string_view(s)) {}
+        string_arg(string_view s) : m_data(s.data()), m_len(s.length()), m_ref(0) {}
+        string_arg(const string &s) : string_arg(string_view(s)) {}
+        constexpr string_arg(interned s) : m_data(nullptr), m_len(0), m_ref(INTERNED_BIT | s.id()) {}
+
+        // Bytes to copy (none for an interned string).
+        const char *data() const { return m_data; }
+        uint32_t length() const { return m_len; }
+        // OR-ed into the length prefix on the wire.
+        uint32_t ref() const { return m_ref; }
+    };
+
+    namespace detail
+    {
+        inline uint32_t next_intern_id = 0;
+    }
+
+    // Feature marker for the INTERN built-in (see emit_headers): present in the
+    // import table iff intern() is used, so app.js only decodes ids then.
+#if defined(__wasm__)
+    extern "C" __attribute__((import_module("w"), import_name("255"))) void __webcc_m_255(void);
+#else
+    extern "C" void __webcc_m_255(void);
+#endif
+
+    inline interned intern(string_view s)
+    {
+        [[maybe_unused]] static void (*const __webcc_keep)(void) __attribute__((used)) = &__webcc_m_255;
+        uint32_t id = detail::next_intern_id++;
+        size_t bytes = WIRE_VERSION >= 2 ? s.length() : CommandCursor::pad4(s.length());
+        if (CommandCursor c = CommandBuffer::reserve(detail::OPCODE_SIZE + 8 + bytes))
+        {
+            detail::put_opcode(c, OP_INTERN);
+            c.u32(id);
+            if constexpr (WIRE_VERSION >= 2)
+                c.str_packed(s.data(), s.length());
+            else
+                c.str(s.data(), s.length());
+            // The id is already handed out, so CommandBuffer::reset() must
+            // not drop its registration.
+            CommandBuffer::commit_kept(c);
+        }
+        return interned(id);
+    }
+
+} // namespace webcc
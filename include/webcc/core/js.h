@@ -34,12 +34,7 @@
 #pragma once
 
 #include <stdint.h>
-
-namespace webcc
-{
-    // Declared in webcc.h; re-declared here so this header is self-contained.
-    void flush();
-}
+#include "../../../src/core/command_buffer.h"
 
 // `name(params){body}` is carried verbatim as the import name (the source itself
 // is the channel). A forwarding wrapper adds the same auto-flush() that webcc's
@@ -52,7 +47,7 @@ namespace webcc
     template <class... __WjsArgs>                                                       \
     static inline ret name(__WjsArgs... __wjs_args)                                     \
     {                                                                                   \
-        ::webcc::flush();                                                               \
+        ::webcc::detail::flush_for(::webcc::FlushReason::InlineJs);                     \
         return __webcc_js_imp_##name(__wjs_args...);                                    \
     }                                                                                   \
     static_assert(true, "require trailing semicolon")
@@ -0,0 +1,188 @@
+#pragma once
+#include "allocator.h"
+#include "new.h"
+#include "utility.h"
+
+// Fixed-size object pool.
+//
+// object_pool<T> carves same-sized slots out of slabs of SlabSize slots each,
+// allocated from the heap one slab at a time. Freed slots go on an intrusive
+// free list threaded through the slots themselves, so create() and destroy()
+// are a couple of loads and stores: no block header, no size-class lookup,
+// and neighbouring objects share cache lines. Slabs are only returned to the
+// heap when the pool is destroyed.
+//
+// Every slot also carries a generation, bumped each time it is freed. A
+// pool_handle records the generation it was issued with, so get() on a handle
+// whose object has since been destroyed (or cleared) returns null instead of
+// whatever reused the slot.
+//
+// Use create()/destroy() for objects, or allocate()/deallocate() as the raw
+// node allocator of a linked structure.
+
+namespace webcc
+{
+    template <typename T>
+    struct pool_handle
+    {
+        uint32_t index = 0xFFFFFFFFu;
+        uint32_t generation = 0;
+
+        bool is_valid() const { return index != 0xFFFFFFFFu; }
+        bool operator==(const pool_handle &o) const { return index == o.index && generation == o.generation; }
+        bool operator!=(const pool_handle &o) const { return !(*this == o); }
+    };
+
+    template <typename T, uint32_t SlabSize = 64>
+    class object_pool
+    {
+        static_assert((SlabSize & (SlabSize - 1)) == 0, "slots are indexed by mask");
+        static_assert(alignof(T) <= detail::ALIGN, "slabs come from webcc::malloc");
+
+        static constexpr uint32_t NONE = 0xFFFFFFFFu;
+
+        struct Slot
+        {
+            alignas(T) unsigned char storage[sizeof(T)];
+            uint32_t generation; // odd while the slot holds an object
+            uint32_t link;       // next free slot while free, own index while live
+        };
+
+        Slot **m_slabs = nullptr;
+        uint32_t m_slab_count = 0;
+        uint32_t m_slab_capacity = 0;
+        uint32_t m_free = NONE; // head of the free list
+        uint32_t m_live = 0;
+
+        Slot &slot(uint32_t index) { return m_slabs[index / SlabSize][index & (SlabSize - 1)]; }
+        static Slot *slot_of(const void *p) { return (Slot *)p; } // storage is the first member
+
+        bool add_slab()
+        {
+            if (m_slab_count == m_slab_capacity)
+            {
+                uint32_t cap = m_slab_capacity ? m_slab_capacity * 2 : 4;
+                Slot **slabs = (Slot **)webcc::realloc(m_slabs, cap * sizeof(Slot *));
+                if (!slabs)
+                    return false;
+                m_slabs = slabs;
+                m_slab_capacity = cap;
+            }
+            Slot *slab = (Slot *)webcc::malloc(SlabSize * sizeof(Slot));
+            if (!slab)
+                return false;
+
+            // Thread the new slots onto the free list in address order.
+            uint32_t base = m_slab_count * SlabSize;
+            for (uint32_t i = 0; i < SlabSize; ++i)
+            {
+                slab[i].generation = 0;
+                slab[i].link = i + 1 < SlabSize ? base + i + 1 : m_free;
+            }
+            m_slabs[m_slab_count++] = slab;
+            m_free = base;
+            return true;
+        }
+
+    public:
+        object_pool() = default;
+        ~object_pool()
+        {
+            clear();
+            for (uint32_t i = 0; i < m_slab_count; ++i)
+                webcc::free(m_slabs[i]);
+            webcc::free(m_slabs);
+        }
+
+        object_pool(const object_pool &) = delete;
+        object_pool &operator=(const object_pool &) = delete;
+
+        // Raw slot of sizeof(T) bytes, or null if the heap is exhausted.
+        void *allocate()
+        {
+            if (m_free == NONE && !add_slab())
+                return nullptr;
+            uint32_t index = m_free;
+            Slot &s = slot(index);
+            m_free = s.link;
+            s.link = index;
+            s.generation++;
+            m_live++;
+            return s.storage;
+        }
+
+        // Return a slot from allocate(). Does not run a destructor.
+        void deallocate(void *p)
+        {
+            if (!p)
+                return;
+            Slot *s = slot_of(p);
+            uint32_t index = s->link;
+            s->generation++;
+            s->link = m_free;
+            m_free = index;
+            m_live--;
+        }
+
+        template <typename... Args>
+        T *create(Args &&...args)
+        {
+            void *mem = allocate();
+            if (!mem)
+                return nullptr;
+            return new (mem) T(webcc::forward<Args>(args)...);
+        }
+
+        void destroy(T *p)
+        {
+            if (!p)
+                return;
+            p->~T();
+            deallocate(p);
+        }
+
+        pool_handle<T> handle_of(const T *p) const
+        {
+            pool_handle<T> h;
+            if (p)
+            {
+                h.index = slot_of(p)->link;
+                h.generation = slot_of(p)->generation;
+            }
+            return h;
+        }
+
+        // The object `h` was issued for, or null if it has been destroyed.
+        T *get(pool_handle<T> h)
+        {
+            if (h.index >= m_slab_count * SlabSize)
+                return nullptr;
+            Slot &s = slot(h.index);
+            return s.generation == h.generation && (s.generation & 1) ? (T *)s.storage : nullptr;
+        }
+
+        void destroy(pool_handle<T> h) { destroy(get(h)); }
+
+        // Destroy every live object at once and make all slots free again,
+        // keeping the slabs. Outstanding handles go stale.
+        void clear()
+        {
+            m_free = NONE;
+            for (uint32_t index = m_slab_count * SlabSize; index-- > 0;)
+            {
+                Slot &s = slot(index);
+                if (s.generation & 1)
+                {
+                    ((T *)s.storage)->~T();
+                    s.generation++;
+                }
+                s.link = m_free;
+                m_free = index;
+            }
+            m_live = 0;
+        }
+
+        uint32_t size() const { return m_live; }
+        uint32_t capacity() const { return m_slab_count * SlabSize; }
+    };
+} // namespace webcc
@@ -6,6 +6,7 @@ namespace webcc
 {
     // Efficient circular buffer queue implementation
     // Optimized for WebAssembly with minimal allocations and cache-friendly access
+    // Always on the heap, with its elements (see detail::heap_scope).
     template <typename T>
     class queue
     {
@@ -18,6 +19,27 @@ namespace webcc
 
         void reallocate(size_t new_capacity)
         {
+            detail::heap_scope heap;
+            // Relocatable elements move as bytes. realloc keeps (or copies)
+            // the block as laid out; if the ring wrapped, the part at the
+            // front of the old block is then copied to just past its end,
+            // which keeps every element in order under the larger mask.
+            if constexpr (is_trivially_relocatable_v<T>)
+            {
+                T* new_data = (T*)webcc::realloc(m_data, new_capacity * sizeof(T));
+                if (!new_data)
+                    return; // Allocation failed
+                if (m_head + m_size > m_capacity)
+                {
+                    size_t wrapped = m_head + m_size - m_capacity;
+                    __builtin_memcpy((void*)(new_data + m_capacity), new_data, wrapped * sizeof(T));
+                }
+                m_data = new_data;
+                m_capacity = new_capacity;
+                m_tail = (m_head + m_size) & (m_capacity - 1);
+                return;
+            }
+
             // Fast path: grow in place only when the ring is laid out linearly
             // from index 0 (m_head == 0). Then the existing elements already sit
             // at [0, m_size) and stay valid under the larger power-of-two mask, so
@@ -83,6 +105,7 @@ namespace webcc
         {
             if (other.m_size > 0)
             {
+                detail::heap_scope heap;
                 m_capacity = other.m_capacity;
                 m_data = (T*)webcc::malloc(m_capacity * sizeof(T));
                 m_size = other.m_size;
@@ -126,6 +149,7 @@ namespace webcc
                 
                 if (other.m_size > 0)
                 {
+                    detail::heap_scope heap;
                     m_capacity = other.m_capacity;
                     m_data = (T*)webcc::malloc(m_capacity * sizeof(T));
                     m_size = other.m_size;
@@ -168,6 +192,7 @@ namespace webcc
 
         void push(const T& value)
         {
+            detail::heap_scope heap;
             if (m_size == m_capacity)
             {
                 size_t new_cap = m_capacity == 0 ? 8 : m_capacity * 2;
@@ -181,6 +206,7 @@ namespace webcc
 
         void push(T&& value)
         {
+            detail::heap_scope heap;
             if (m_size == m_capacity)
             {
                 size_t new_cap = m_capacity == 0 ? 8 : m_capacity * 2;
@@ -195,6 +221,7 @@ namespace webcc
         template<typename... Args>
         void emplace(Args&&... args)
         {
+            detail::heap_scope heap;
             if (m_size == m_capacity)
             {
                 size_t new_cap = m_capacity == 0 ? 8 : m_capacity * 2;
@@ -248,4 +275,10 @@ namespace webcc
             m_tail = 0;
         }
     };
+
+    template <typename T>
+    struct is_trivially_relocatable<queue<T>>
+    {
+        static constexpr bool value = true;
+    };
 } // namespace webcc
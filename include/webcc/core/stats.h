@@ -0,0 +1,126 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "../../../src/core/command_buffer.h"
+
+// Flush statistics, collected by the instrumented build (`webcc --stats`,
+// which compiles with WEBCC_STATS and has app.js time its decode loop).
+//
+//   * Every committed command is counted, with its bytes, under its opcode.
+//     Built-ins (BIND, INTERN, REPLAY, ...) count under their own opcodes, so
+//     a replayed display list shows up as one small REPLAY.
+//   * Every flush records why it ran (see FlushReason) and how long app.js
+//     spent decoding it. Getter and WEBCC_JS flushes are the boundary
+//     crossings worth hunting: each one ends a batch early.
+//
+// Per namespace, sum the opcodes its generated header lists:
+//
+//     auto canvas = webcc::stats::totals().sent.sum(webcc::canvas::OPCODES);
+//
+// Input latency: app.js stamps every event it pushes, and for each event type
+// two histograms collect how long events waited until next_event() handed
+// them to the app, and until the end of the flush after that, i.e. until the
+// commands they led to reached JS:
+//
+//     auto &moves = webcc::stats::event_latency(webcc::input::EVENT_MOUSE_MOVE);
+//     uint32_t p99_us = moves.flush.percentile(0.99);
+//
+// A coalesced or batched event keeps the stamp of its first push.
+//
+// In a normal build enabled() is false and every counter stays zero.
+
+namespace webcc::stats
+{
+    struct Counter
+    {
+        uint64_t commands;
+        uint64_t bytes;
+    };
+
+    struct Counters
+    {
+        Counter ops[256]; // by opcode
+        Counter all;
+
+        template <size_t N>
+        Counter sum(const uint8_t (&opcodes)[N]) const
+        {
+            Counter c = {0, 0};
+            for (uint8_t op : opcodes)
+            {
+                c.commands += ops[op].commands;
+                c.bytes += ops[op].bytes;
+            }
+            return c;
+        }
+    };
+
+    // One batch handed to JS.
+    struct FlushStats
+    {
+        Counters sent;
+        double decode_ms; // time app.js spent in its decode loop
+        FlushReason reason;
+    };
+
+    // Everything since start-up (or the last reset()). app.js reads this
+    // struct directly for its console table; stats.cc pins the layout.
+    struct Totals
+    {
+        Counters sent;
+        double decode_ms;
+        double decode_max_ms;
+        uint32_t requests[FLUSH_REASON_COUNT]; // flush() calls, by reason
+        uint32_t flushes[FLUSH_REASON_COUNT];  // the ones that had commands to send
+    };
+
+    // Microsecond latencies in log-spaced buckets: four per power of two, so
+    // a percentile overstates the real value by at most 25%.
+    struct LatencyHistogram
+    {
+        static constexpr int BUCKETS = 128;
+        uint32_t counts[BUCKETS];
+        uint32_t samples;
+        uint32_t max_us;
+
+        // Upper bound of the bucket holding the `p` quantile (0..1), or 0
+        // without samples.
+        uint32_t percentile(double p) const;
+        uint32_t p50() const { return percentile(0.50); }
+        uint32_t p95() const { return percentile(0.95); }
+        uint32_t p99() const { return percentile(0.99); }
+    };
+
+    struct EventLatency
+    {
+        LatencyHistogram drain; // push -> next_event()
+        LatencyHistogram flush; // push -> end of the next non-empty flush
+    };
+
+    // Event opcodes are numbered from 1; later ones are not tracked.
+    constexpr uint32_t MAX_EVENT_TYPES = 64;
+
+    constexpr bool enabled()
+    {
+#ifdef WEBCC_STATS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Commands encoded since the last flush.
+    const FlushStats &pending();
+    const FlushStats &last_flush();
+    const Totals &totals();
+    const EventLatency &event_latency(uint8_t opcode);
+    void reset();
+
+    // Called after every flush, with that flush's numbers.
+    void set_flush_hook(void (*hook)(const FlushStats &));
+
+    // Log the totals as console tables (by namespace, by command, by flush
+    // reason). The same report is `webcc_stats()` in the browser console.
+    void print();
+
+} // namespace webcc::stats
@@ -1,7 +1,9 @@
 #pragma once
 #include "allocator.h"
+#include "frame_arena.h"
 #include "string_view.h"
 #include "format.h"
+#include "utility.h"
 
 namespace webcc
 {
@@ -9,15 +11,15 @@ namespace webcc
     {
     private:
         char *m_data = nullptr;
-        uint32_t m_len = 0;
+        // A bitfield promotes to int in arithmetic: cast back to uint32_t
+        // (or add 1u) wherever it meets unsigned values.
+        uint32_t m_len : 31 = 0;
+        // Constructed inside a frame_scope: buffers come from the frame arena.
+        uint32_t m_frame : 1 = detail::in_frame_scope();
 
         static uint32_t strlen(const char *s)
         {
-            uint32_t l = 0;
-            if (!s) return 0;
-            while (s[l])
-                l++;
-            return l;
+            return s ? (uint32_t)__builtin_strlen(s) : 0;
         }
 
         // Private: take ownership of an existing buffer (used by concat)
@@ -34,9 +36,8 @@ namespace webcc
         {
             if (s) {
                 m_len = strlen(s);
-                m_data = (char *)webcc::malloc(m_len + 1);
-                for (uint32_t i = 0; i < m_len; i++)
-                    m_data[i] = s[i];
+                m_data = (char *)detail::scoped_malloc(m_len + 1u, m_frame);
+                __builtin_memcpy(m_data, s, m_len);
                 m_data[m_len] = '\0';
             } else {
                 m_data = nullptr;
@@ -48,9 +49,8 @@ namespace webcc
         {
             m_len = len;
             if (len > 0) {
-                m_data = (char *)webcc::malloc(m_len + 1);
-                for (uint32_t i = 0; i < m_len; i++)
-                    m_data[i] = s[i];
+                m_data = (char *)detail::scoped_malloc(m_len + 1u, m_frame);
+                __builtin_memcpy(m_data, s, m_len);
                 m_data[m_len] = '\0';
             } else {
                 m_data = nullptr;
@@ -64,9 +64,8 @@ namespace webcc
         {
             m_len = other.m_len;
             if (other.m_data) {
-                m_data = (char *)webcc::malloc(m_len + 1);
-                for (uint32_t i = 0; i <= m_len; i++)
-                    m_data[i] = other.m_data[i];
+                m_data = (char *)detail::scoped_malloc(m_len + 1u, m_frame);
+                __builtin_memcpy(m_data, other.m_data, m_len + 1u);
             } else {
                 m_data = nullptr;
             }
@@ -77,15 +76,14 @@ namespace webcc
         {
             if (this != &other)
             {
-                webcc::free(m_data);
-                m_len = other.m_len;
+                char *data = nullptr;
                 if (other.m_data) {
-                    m_data = (char *)webcc::malloc(m_len + 1);
-                    for (uint32_t i = 0; i <= m_len; i++)
-                        m_data[i] = other.m_data[i];
-                } else {
-                    m_data = nullptr;
+                    data = (char *)detail::scoped_malloc(other.m_len + 1u, m_frame);
+                    __builtin_memcpy(data, other.m_data, other.m_len + 1u);
                 }
+                detail::scoped_free(m_data);
+                m_data = data;
+                m_len = other.m_len;
             }
             return *this;
         }
@@ -93,6 +91,12 @@ namespace webcc
         // Move constructor (Zero-cost transfer of ownership)
         string(string &&other) noexcept
         {
+            // A heap string never adopts frame memory; copy the bytes out.
+            if (!m_frame && detail::frame_owned(other.m_data))
+            {
+                *this = static_cast<const string &>(other);
+                return;
+            }
             m_data = other.m_data;
             m_len = other.m_len;
             other.m_data = nullptr;
@@ -104,7 +108,11 @@ namespace webcc
         {
             if (this != &other)
             {
-                webcc::free(m_data);
+                // Don't let a heap string adopt frame memory (e.g. `s += x`
+                // inside a frame_scope); copy the bytes instead.
+                if (!m_frame && detail::frame_owned(other.m_data))
+                    return *this = static_cast<const string &>(other);
+                detail::scoped_free(m_data);
                 m_data = other.m_data;
                 m_len = other.m_len;
                 other.m_data = nullptr;
@@ -113,7 +121,7 @@ namespace webcc
             return *this;
         }
 
-        ~string() { webcc::free(m_data); }
+        ~string() { detail::scoped_free(m_data); }
 
         template <typename... Args>
         static string concat(Args... args)
@@ -153,7 +161,7 @@ namespace webcc
         // substr(pos, len) - get substring starting at pos with length len
         string substr(uint32_t pos, uint32_t len = 0xFFFFFFFF) const {
             if (pos >= m_len) return string();
-            uint32_t actual_len = (len > m_len - pos) ? (m_len - pos) : len;
+            uint32_t actual_len = (len > m_len - pos) ? (uint32_t)(m_len - pos) : len;
             return string(m_data + pos, actual_len);
         }
 
@@ -161,7 +169,8 @@ namespace webcc
         bool contains(const string& needle) const {
             if (needle.m_len == 0) return true;
             if (needle.m_len > m_len) return false;
-            for (uint32_t i = 0; i <= m_len - needle.m_len; i++) {
+            uint32_t last = (uint32_t)(m_len - needle.m_len);
+            for (uint32_t i = 0; i <= last; i++) {
                 bool match = true;
                 for (uint32_t j = 0; j < needle.m_len && match; j++) {
                     if (m_data[i + j] != needle.m_data[j]) match = false;
@@ -184,7 +193,7 @@ namespace webcc
                 start++;
             }
             if (start == m_len) return string();
-            return string(m_data + start, m_len - start);
+            return string(m_data + start, (uint32_t)(m_len - start));
         }
 
         // Trim whitespace from end
@@ -366,4 +375,10 @@ namespace webcc
             return *this >= string(other);
         }
     };
+
+    template <>
+    struct is_trivially_relocatable<string>
+    {
+        static constexpr bool value = true;
+    };
 } // namespace webcc
@@ -75,4 +75,10 @@ namespace webcc
         return unique_ptr<T>((T*)mem);
     }
 
+    template<typename T>
+    struct is_trivially_relocatable<unique_ptr<T>>
+    {
+        static constexpr bool value = true;
+    };
+
 } // namespace webcc
@@ -9,6 +9,7 @@ namespace webcc
     // A lightweight open-addressing hash map implementation.
     // Uses linear probing for collision resolution.
     // Does not support standard node-based stability guarantees, but is cache-friendly.
+    // Always on the heap, with its keys and values (see detail::heap_scope).
     template <typename Key, typename T, typename Hash = webcc::hash<Key>>
     class unordered_map
     {
@@ -62,6 +63,7 @@ namespace webcc
 
         void insert_internal(Key&& key, T&& value)
         {
+            detail::heap_scope heap;
             // Check load factor (0.7)
             if (m_size >= m_capacity * 0.7) {
                 rehash(m_capacity == 0 ? 16 : m_capacity * 2);
@@ -139,6 +141,7 @@ namespace webcc
 
             if (insertion_idx == (size_t)-1) insertion_idx = idx;
 
+            detail::heap_scope heap;
             new (&m_data[insertion_idx].key) Key(key);
             new (&m_data[insertion_idx].value) T();
             m_data[insertion_idx].state = OCCUPIED;
@@ -232,4 +235,10 @@ namespace webcc
             }
         }
     };
+
+    template <typename Key, typename T, typename Hash>
+    struct is_trivially_relocatable<unordered_map<Key, T, Hash>>
+    {
+        static constexpr bool value = is_trivially_relocatable_v<Hash>;
+    };
 } // namespace webcc
@@ -21,6 +21,20 @@ namespace webcc
         return static_cast<T&&>(t);
     }
 
+    // True when moving a T to a new address and ending the old object's
+    // lifetime is the same as copying its bytes: no self-pointers, no
+    // registration by address. Containers then grow with realloc and shift
+    // with memmove instead of moving elements one at a time. Holds for every
+    // trivially copyable type; owning types that only hold heap pointers
+    // (string, vector, ...) specialise it next to their definition.
+    template<typename T>
+    struct is_trivially_relocatable
+    {
+        static constexpr bool value = __is_trivially_copyable(T);
+    };
+    template<typename T>
+    inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
     template<typename T>
     void swap(T& a, T& b)
     {
@@ -97,6 +111,12 @@ namespace webcc
         }
     };
 
+    template<typename T1, typename T2>
+    struct is_trivially_relocatable<pair<T1, T2>>
+    {
+        static constexpr bool value = is_trivially_relocatable_v<T1> && is_trivially_relocatable_v<T2>;
+    };
+
     // Comparison operators
     template<typename T1, typename T2>
     bool operator==(const pair<T1, T2>& lhs, const pair<T1, T2>& rhs)
@@ -1,5 +1,6 @@
 #pragma once
 #include "allocator.h"
+#include "frame_arena.h"
 #include "new.h"
 #include "utility.h"
 #include "algorithm.h" // for sort
@@ -14,22 +15,52 @@ namespace webcc
     private:
         T *m_data = nullptr;
         size_t m_size = 0;
-        size_t m_capacity = 0;
+        size_t m_capacity : sizeof(size_t) * 8 - 1 = 0;
+        // Constructed inside a frame_scope: buffers come from the frame arena.
+        // Otherwise the elements it constructs stay on the heap too.
+        size_t m_frame : 1 = detail::in_frame_scope();
+
+        // Move other's elements into a buffer of our own (a heap vector
+        // handed frame memory), leaving other empty.
+        void move_elements_from(vector &other)
+        {
+            detail::heap_scope heap;
+            reserve(other.m_size);
+            size_t limit = (m_capacity < other.m_size) ? m_capacity : other.m_size;
+            for (size_t i = 0; i < limit; ++i)
+                new (m_data + i) T(webcc::move(other.m_data[i]));
+            m_size = limit;
+            other.clear();
+        }
 
         void reallocate(size_t new_capacity)
         {
+            // Relocatable elements move as bytes: realloc grows in place when
+            // it can and otherwise copies the block in one go.
+            if constexpr (is_trivially_relocatable_v<T>)
+            {
+                T *block = m_data ? (T *)detail::scoped_realloc(m_data, m_size * sizeof(T), new_capacity * sizeof(T))
+                                  : (T *)detail::scoped_malloc(new_capacity * sizeof(T), m_frame);
+                if (!block)
+                    return; // Allocation failed
+                m_data = block;
+                m_capacity = new_capacity;
+                return;
+            }
+
             // Fast path: enlarge the existing block in place. No element moves,
             // so this is safe for every T (no constructors run) and avoids the
             // allocate-copy-free round trip entirely when the block can grow.
             if (m_data && new_capacity > m_capacity &&
-                webcc::try_grow_inplace(m_data, new_capacity * sizeof(T)))
+                detail::scoped_try_grow_inplace(m_data, new_capacity * sizeof(T)))
             {
                 m_capacity = new_capacity;
                 return;
             }
 
             // 1. Allocate new block
-            T *new_block = (T *)webcc::malloc(new_capacity * sizeof(T));
+            detail::heap_scope heap(!m_frame);
+            T *new_block = (T *)detail::scoped_malloc(new_capacity * sizeof(T), m_frame);
             if (!new_block)
                 return; // Allocation failed
 
@@ -41,7 +72,7 @@ namespace webcc
                     new (new_block + i) T(webcc::move(m_data[i]));
                     m_data[i].~T();
                 }
-                webcc::free(m_data);
+                detail::scoped_free(m_data);
             }
 
             m_data = new_block;
@@ -71,7 +102,7 @@ namespace webcc
         ~vector()
         {
             clear();
-            webcc::free(m_data);
+            detail::scoped_free(m_data);
         }
 
         // Copy constructor
@@ -79,6 +110,7 @@ namespace webcc
         {
             if (other.m_size > 0)
             {
+                detail::heap_scope heap(!m_frame);
                 reserve(other.m_size);
                 size_t limit = (m_capacity < other.m_size) ? m_capacity : other.m_size;
                 for (size_t i = 0; i < limit; ++i)
@@ -94,6 +126,7 @@ namespace webcc
         {
             if (this != &other)
             {
+                detail::heap_scope heap(!m_frame);
                 clear();
                 reserve(other.m_size);
                 size_t limit = (m_capacity < other.m_size) ? m_capacity : other.m_size;
@@ -108,8 +141,16 @@ namespace webcc
 
         // Move constructor
         vector(vector &&other) noexcept
-            : m_data(other.m_data), m_size(other.m_size), m_capacity(other.m_capacity)
         {
+            // A heap vector never adopts frame memory.
+            if (!m_frame && detail::frame_owned(other.m_data))
+            {
+                move_elements_from(other);
+                return;
+            }
+            m_data = other.m_data;
+            m_size = other.m_size;
+            m_capacity = other.m_capacity;
             other.m_data = nullptr;
             other.m_size = 0;
             other.m_capacity = 0;
@@ -121,7 +162,15 @@ namespace webcc
             if (this != &other)
             {
                 clear();
-                webcc::free(m_data);
+
+                // A heap vector doesn't adopt frame memory: move the elements
+                // into its own buffer instead.
+                if (!m_frame && detail::frame_owned(other.m_data))
+                {
+                    move_elements_from(other);
+                    return *this;
+                }
+                detail::scoped_free(m_data);
 
                 m_data = other.m_data;
                 m_size = other.m_size;
@@ -136,6 +185,7 @@ namespace webcc
 
         void push_back(const T &value)
         {
+            detail::heap_scope heap(!m_frame);
             if (m_size == m_capacity)
             {
                 size_t new_cap = m_capacity == 0 ? 4 : m_capacity * 2;
@@ -150,6 +200,7 @@ namespace webcc
 
         void push_back(T &&value)
         {
+            detail::heap_scope heap(!m_frame);
             if (m_size == m_capacity)
             {
                 size_t new_cap = m_capacity == 0 ? 4 : m_capacity * 2;
@@ -165,6 +216,7 @@ namespace webcc
         template <typename... Args>
         void emplace_back(Args &&...args)
         {
+            detail::heap_scope heap(!m_frame);
             if (m_size == m_capacity)
             {
                 size_t new_cap = m_capacity == 0 ? 4 : m_capacity * 2;
@@ -186,16 +238,61 @@ namespace webcc
             }
         }
 
+        // Insert before index (index == size() appends), shifting the
+        // following elements up. Out-of-range indices are ignored.
+        void insert(size_t index, const T &value)
+        {
+            detail::heap_scope heap(!m_frame);
+            T copy(value); // `value` may live in this vector
+            insert(index, webcc::move(copy));
+        }
+
+        void insert(size_t index, T &&value)
+        {
+            if (index > m_size)
+                return;
+            detail::heap_scope heap(!m_frame);
+            if (m_size == m_capacity)
+            {
+                size_t new_cap = m_capacity == 0 ? 4 : m_capacity * 2;
+                reallocate(new_cap);
+            }
+            if (m_size == m_capacity)
+                return; // Allocation failed
+            if constexpr (is_trivially_relocatable_v<T>)
+            {
+                __builtin_memmove((void *)(m_data + index + 1), m_data + index, (m_size - index) * sizeof(T));
+            }
+            else
+            {
+                for (size_t i = m_size; i > index; --i)
+                {
+                    new (m_data + i) T(webcc::move(m_data[i - 1]));
+                    m_data[i - 1].~T();
+                }
+            }
+            new (m_data + index) T(webcc::move(value));
+            m_size++;
+        }
+
         // Erase element at index, shifting remaining elements
         void erase(size_t index)
         {
             if (index >= m_size)
                 return;
+            detail::heap_scope heap(!m_frame);
             m_data[index].~T();
-            for (size_t i = index; i < m_size - 1; ++i)
+            if constexpr (is_trivially_relocatable_v<T>)
             {
-                new (m_data + i) T(webcc::move(m_data[i + 1]));
-                m_data[i + 1].~T();
+                __builtin_memmove((void *)(m_data + index), m_data + index + 1, (m_size - index - 1) * sizeof(T));
+            }
+            else
+            {
+                for (size_t i = index; i < m_size - 1; ++i)
+                {
+                    new (m_data + i) T(webcc::move(m_data[i + 1]));
+                    m_data[i + 1].~T();
+                }
             }
             m_size--;
         }
@@ -212,6 +309,7 @@ namespace webcc
         {
             if (new_size > m_size)
             {
+                detail::heap_scope heap(!m_frame);
                 reserve(new_size);
                 size_t limit = (m_capacity < new_size) ? m_capacity : new_size;
                 for (size_t i = m_size; i < limit; ++i)
@@ -283,4 +381,10 @@ namespace webcc
         const_iterator begin() const { return m_data; }
         const_iterator end() const { return m_data + m_size; }
     };
+
+    template <typename T>
+    struct is_trivially_relocatable<vector<T>>
+    {
+        static constexpr bool value = true;
+    };
 } // namespace webcc
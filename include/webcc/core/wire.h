@@ -0,0 +1,11 @@
+// GENERATED FILE - DO NOT EDIT
+#pragma once
+
+namespace webcc {
+
+    // Command wire format selected by schema.def (meta|wire): 1 = aligned
+    // 4-byte fields, 2 = compact. Lets hand-written encoders (e.g. intern())
+    // match the generated wrappers.
+    constexpr int WIRE_VERSION = 1;
+
+} // namespace webcc
@@ -6,6 +6,7 @@
 #include "../../src/core/event_buffer.h"
 #include "../../src/core/scratch_buffer.h"
 #include "core/optional.h"
+#include "core/string_view.h"
 #include "core/js.h"
 
 namespace webcc
@@ -13,34 +14,58 @@ namespace webcc
     // The trigger. This calls a JS function (imported)
     void flush();
 
-    // Internal helpers for command serialization
+    namespace detail {
+        // Worst-case encoded size and writer for each push_command argument.
+        inline constexpr size_t arg_size(uint32_t) { return 4; }
+        inline constexpr size_t arg_size(int32_t) { return 4; }
+        inline constexpr size_t arg_size(float) { return 4; }
+        inline constexpr size_t arg_size(double) { return 12; } // may need a pad word
+        inline size_t arg_size(string_view s) { return 4 + CommandCursor::pad4(s.length()); }
+
+        inline void put_arg(CommandCursor& c, uint32_t v) { c.u32(v); }
+        inline void put_arg(CommandCursor& c, int32_t v) { c.i32(v); }
+        inline void put_arg(CommandCursor& c, float v) { c.f32(v); }
+        inline void put_arg(CommandCursor& c, double v) { c.f64(v); }
+        inline void put_arg(CommandCursor& c, string_view s) { c.str(s.data(), s.length()); }
+    }
+
+    // Append one whole command: the opcode and its arguments are reserved
+    // together, so an overflow flush can only happen before the opcode and
+    // never leaves a command split across two batches.
+    template<typename... Args>
+    inline void push_command(uint32_t opcode, Args... args){
+        if (auto c = CommandBuffer::reserve(4 + (detail::arg_size(args) + ... + 0))) {
+            c.u32(opcode);
+            (detail::put_arg(c, args), ...);
+            CommandBuffer::commit(c);
+        }
+    }
+
+    // Each call reserves on its own, so an overflow flush can separate the
+    // value from the opcode before it.
     template<typename T>
-    inline void push_data(T value);
+    [[deprecated("use push_command(opcode, args...)")]] inline void push_data(T value);
 
     template<>
-    inline void push_data<uint32_t>(uint32_t value){
+    [[deprecated("use push_command(opcode, args...)")]] inline void push_data<uint32_t>(uint32_t value){
         CommandBuffer::push_u32(value);
     }
 
     template<>
-    inline void push_data<int32_t>(int32_t value){
+    [[deprecated("use push_command(opcode, args...)")]] inline void push_data<int32_t>(int32_t value){
         CommandBuffer::push_i32(value);
     }
 
     template<>
-    inline void push_data<float>(float value){
+    [[deprecated("use push_command(opcode, args...)")]] inline void push_data<float>(float value){
         CommandBuffer::push_float(value);
     }
 
     template<>
-    inline void push_data<double>(double value){
+    [[deprecated("use push_command(opcode, args...)")]] inline void push_data<double>(double value){
         CommandBuffer::push_double(value);
     }
 
-    inline void push_command(uint32_t opcode){
-        CommandBuffer::push_u32(opcode);
-    }
-
     struct Event {
         uint8_t opcode;
         const uint8_t* data;
@@ -55,6 +80,7 @@ namespace webcc
         }
     };
 
+    // `event.data` stays valid until the next poll_event() call.
     inline bool poll_event(Event& event) {
         return next_event(event.opcode, &event.data, event.len);
     }
@@ -64,6 +90,33 @@ namespace webcc
         return T::parse(data, len);
     }
 
+    // Merges lambdas into one overload set, e.g. for dispatch_events().
+    template <typename... Fs>
+    struct overloaded : Fs... {
+        using Fs::operator()...;
+    };
+    template <typename... Fs>
+    overloaded(Fs...) -> overloaded<Fs...>;
+
+    namespace detail {
+        // One case of the generated dispatch_events() switch (webcc/events.h).
+        // The payload is parsed straight into the handler's argument; events
+        // with no matching overload go to a `const Event&` one, if any.
+        template <typename T, typename H>
+        inline void dispatch_event(H& handler, const Event& e) {
+            if constexpr (requires { handler(T::parse(e.data, e.len)); })
+                handler(T::parse(e.data, e.len));
+            else if constexpr (requires { handler(e); })
+                handler(e);
+        }
+
+        template <typename H>
+        inline void dispatch_other(H& handler, const Event& e) {
+            if constexpr (requires { handler(e); })
+                handler(e);
+        }
+    }
+
     // =========================================================================
     // Deferred DOM element creation (for batched DOM creation)
     // C++ assigns handles from a high starting number to avoid collision with
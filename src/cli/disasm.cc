@@ -0,0 +1,484 @@
+#include "disasm.h"
+#include "utils.h"
+#include "command_buffer.h"
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <vector>
+
+namespace webcc
+{
+    namespace
+    {
+        constexpr uint32_t INTERNED_BIT = 0x80000000u; // see webcc/core/intern.h
+
+        // Bounds-checked little-endian reader over a byte string. A read past
+        // the end sets `bad` and returns zero, so callers check once at the end
+        // of a command instead of after every field.
+        struct Reader
+        {
+            const std::string &b;
+            size_t pos;
+            size_t end;
+            bool bad = false;
+
+            bool has(size_t n)
+            {
+                if (bad || n > end - pos)
+                    bad = true;
+                return !bad;
+            }
+            uint8_t u8()
+            {
+                return has(1) ? (uint8_t)b[pos++] : 0;
+            }
+            uint32_t u32()
+            {
+                if (!has(4))
+                    return 0;
+                uint32_t v;
+                std::memcpy(&v, b.data() + pos, 4);
+                pos += 4;
+                return v;
+            }
+            int32_t i32() { return (int32_t)u32(); }
+            float f32()
+            {
+                uint32_t bits = u32();
+                float v;
+                std::memcpy(&v, &bits, 4);
+                return v;
+            }
+            double f64()
+            {
+                if (!has(8))
+                    return 0;
+                double v;
+                std::memcpy(&v, b.data() + pos, 8);
+                pos += 8;
+                return v;
+            }
+            std::string bytes(size_t n)
+            {
+                if (!has(n))
+                    return "";
+                std::string s = b.substr(pos, n);
+                pos += n;
+                return s;
+            }
+            void pad4() { pos += std::min((4 - (pos & 3)) & 3, end - pos); }
+        };
+
+        std::string quote(const std::string &s)
+        {
+            std::string out = "\"";
+            for (unsigned char c : s)
+            {
+                if (c == '"' || c == '\\')
+                    out += std::string("\\") + (char)c;
+                else if (c == '\n')
+                    out += "\\n";
+                else if (c < 0x20)
+                {
+                    char hex[8];
+                    std::snprintf(hex, sizeof(hex), "\\x%02x", c);
+                    out += hex;
+                }
+                else
+                    out += (char)c;
+            }
+            return out + "\"";
+        }
+
+        std::string number(double v)
+        {
+            std::ostringstream ss;
+            ss << v;
+            return ss.str();
+        }
+
+        struct Tally
+        {
+            uint64_t commands = 0;
+            uint64_t bytes = 0;
+        };
+
+        struct Frame
+        {
+            uint32_t flushes = 0;
+            uint32_t calls = 0;
+            uint64_t commands = 0;
+            uint64_t bytes = 0;
+        };
+
+        // Walks the flushes of one capture, keeping the state that spans them
+        // (interned strings) and the running statistics.
+        class Disassembler
+        {
+        public:
+            Disassembler(const SchemaDefs &defs, std::ostream &out, const DisasmOptions &options)
+                : out_(out), options_(options), compact_(defs.wire_version >= 2)
+            {
+                for (const auto &c : defs.commands)
+                    if (c.return_type.empty())
+                        by_opcode_[c.opcode] = &c;
+            }
+
+            void flush(const std::string &data, uint32_t ptr, Frame &frame)
+            {
+                frame.flushes++;
+                frame.bytes += data.size();
+                if (!options_.summary_only)
+                    out_ << "  flush @0x" << std::hex << ptr << std::dec << ", " << data.size() << " bytes\n";
+                Reader r{data, 0, data.size()};
+                while (r.pos < r.end)
+                {
+                    size_t start = r.pos;
+                    std::string name, args;
+                    if (!command(r, ptr, name, args))
+                    {
+                        listing(start, "?? " + args);
+                        return;
+                    }
+                    Tally &t = tally_[name];
+                    t.commands++;
+                    t.bytes += r.pos - start;
+                    frame.commands++;
+                    listing(start, name + (args.empty() ? "" : " " + args));
+                }
+            }
+
+            void call(const std::string &name, const std::string &args, Frame &frame)
+            {
+                frame.calls++;
+                calls_[name]++;
+                if (!options_.summary_only)
+                    out_ << "  call " << name << "(" << args << ")\n";
+            }
+
+            void summary(const std::vector<std::pair<uint32_t, Frame>> &frames)
+            {
+                uint64_t flushes = 0, commands = 0, bytes = 0;
+                uint64_t min_bytes = UINT64_MAX, max_bytes = 0;
+                uint32_t max_frame = 0;
+                for (const auto &f : frames)
+                {
+                    flushes += f.second.flushes;
+                    commands += f.second.commands;
+                    bytes += f.second.bytes;
+                    min_bytes = std::min(min_bytes, f.second.bytes);
+                    if (f.second.bytes >= max_bytes)
+                    {
+                        max_bytes = f.second.bytes;
+                        max_frame = f.first;
+                    }
+                }
+                size_t n = frames.size();
+                out_ << "\n"
+                     << n << " frames, " << flushes << " flushes, " << commands << " commands, " << bytes << " bytes\n";
+                if (n)
+                {
+                    out_ << "bytes/frame: min " << min_bytes << ", avg " << bytes / n << ", max " << max_bytes
+                         << " (frame " << max_frame << ")\n";
+                    out_ << "commands/frame: avg " << std::fixed << std::setprecision(1) << (double)commands / n
+                         << ", flushes/frame: avg " << (double)flushes / n << std::defaultfloat << "\n";
+                }
+
+                std::vector<std::pair<std::string, Tally>> rows(tally_.begin(), tally_.end());
+                std::sort(rows.begin(), rows.end(), [](const auto &a, const auto &b)
+                          { return a.second.bytes != b.second.bytes ? a.second.bytes > b.second.bytes : a.first < b.first; });
+                if (!rows.empty())
+                    out_ << "\nby command (bytes, commands, bytes/command):\n";
+                for (const auto &row : rows)
+                    out_ << "  " << std::left << std::setw(32) << row.first << std::right << std::setw(10) << row.second.bytes
+                         << std::setw(10) << row.second.commands << std::setw(8) << std::fixed << std::setprecision(1)
+                         << (double)row.second.bytes / row.second.commands << std::defaultfloat << "\n";
+                if (!calls_.empty())
+                    out_ << "\nreturn-value calls:\n";
+                for (const auto &c : calls_)
+                    out_ << "  " << std::left << std::setw(32) << c.first << std::right << std::setw(10) << c.second << "\n";
+            }
+
+        private:
+            void listing(size_t offset, const std::string &text)
+            {
+                if (!options_.summary_only)
+                    out_ << "    +" << std::left << std::setw(6) << offset << std::right << text << "\n";
+            }
+
+            // Decodes one command at `r.pos` into its name and arguments.
+            // On a stream it cannot follow, returns false with the reason in
+            // `args`.
+            bool command(Reader &r, uint32_t ptr, std::string &name, std::string &args)
+            {
+                uint8_t op = compact_ ? r.u8() : (uint8_t)r.u32();
+                if (r.bad)
+                {
+                    args = "truncated opcode";
+                    return false;
+                }
+                std::ostringstream a;
+                switch (op)
+                {
+                case OP_BIND:
+                {
+                    uint8_t slot = r.u8();
+                    int32_t handle = r.i32();
+                    bound_[slot & (MAX_BIND_SLOTS - 1)] = handle;
+                    name = "webcc.bind";
+                    a << "slot=" << (int)slot << " handle=" << handle;
+                    break;
+                }
+                case OP_INTERN:
+                {
+                    uint32_t id = r.u32();
+                    uint32_t len = r.u32();
+                    std::string s = r.bytes(len);
+                    if (!compact_)
+                        r.pad4();
+                    interned_[id] = s;
+                    name = "webcc.intern";
+                    a << "id=" << id << " " << quote(s);
+                    break;
+                }
+                case OP_BEGIN_RECORD:
+                    name = "webcc.begin_record";
+                    a << "list=" << r.u32();
+                    break;
+                case OP_END_RECORD:
+                    name = "webcc.end_record";
+                    break;
+                case OP_REPLAY:
+                    name = "webcc.replay";
+                    a << "list=" << r.u32();
+                    break;
+                case OP_DISCARD_LIST:
+                    name = "webcc.discard_list";
+                    a << "list=" << r.u32();
+                    break;
+                default:
+                {
+                    auto it = by_opcode_.find(op);
+                    if (it == by_opcode_.end())
+                    {
+                        std::ostringstream why;
+                        why << "unknown opcode 0x" << std::hex << (int)op << std::dec << "; rest of flush skipped";
+                        args = why.str();
+                        return false;
+                    }
+                    const SchemaCommand &c = *it->second;
+                    name = c.ns + "." + c.func_name;
+                    params(r, ptr, c, a);
+                }
+                }
+                if (r.bad)
+                {
+                    args = "truncated " + name;
+                    return false;
+                }
+                args = a.str();
+                return true;
+            }
+
+            void params(Reader &r, uint32_t ptr, const SchemaCommand &c, std::ostream &a)
+            {
+                for (size_t i = 0; i < c.params.size(); ++i)
+                {
+                    const SchemaParam &p = c.params[i];
+                    if (i)
+                        a << " ";
+                    a << (p.name.empty() ? "arg" + std::to_string(i) : p.name) << "=";
+                    if (i == 0 && c.bind_slot >= 0)
+                    {
+                        a << "@" << bound_[c.bind_slot];
+                        continue;
+                    }
+                    if (p.type == "string")
+                    {
+                        uint32_t len = r.u32();
+                        if (len & INTERNED_BIT)
+                        {
+                            uint32_t id = len & ~INTERNED_BIT;
+                            auto it = interned_.find(id);
+                            a << "#" << id;
+                            if (it != interned_.end())
+                                a << quote(it->second);
+                            continue;
+                        }
+                        a << quote(r.bytes(len));
+                        if (!c.compact)
+                            r.pad4();
+                    }
+                    else if (p.type == "uint8")
+                        a << (int)(c.compact ? r.u8() : (uint8_t)r.u32());
+                    else if (p.type == "int32" || p.type == "handle")
+                        a << r.i32();
+                    else if (p.type == "uint32" || p.type == "func_ptr")
+                        a << r.u32();
+                    else if (p.type == "float32" || (p.type == "float64" && c.narrow_floats))
+                        a << number(r.f32());
+                    else if (p.type == "float64")
+                    {
+                        // v1 doubles sit on an 8-byte boundary of the address
+                        // the flush was read from.
+                        if (!c.compact && ((ptr + r.pos) & 4))
+                            r.u32();
+                        a << number(r.f64());
+                    }
+                    else
+                        a << "?" << p.type;
+                }
+            }
+
+            std::ostream &out_;
+            const DisasmOptions &options_;
+            bool compact_;
+            std::map<uint8_t, const SchemaCommand *> by_opcode_;
+            std::map<uint32_t, std::string> interned_;
+            int32_t bound_[MAX_BIND_SLOTS] = {INT32_MIN, INT32_MIN, INT32_MIN, INT32_MIN};
+            std::map<std::string, Tally> tally_;
+            std::map<std::string, uint64_t> calls_;
+        };
+
+        // "webcc_canvas_get_context_2d" -> "canvas.get_context_2d", when the
+        // schema knows it.
+        std::string call_name(const SchemaDefs &defs, const std::string &import)
+        {
+            for (const auto &c : defs.commands)
+                if (!c.return_type.empty() && import == "webcc_" + c.ns + "_" + c.func_name)
+                    return c.ns + "." + c.func_name;
+            return import;
+        }
+    }
+
+    bool disasm_capture(const SchemaDefs &defs, const std::string &data, std::ostream &out, const DisasmOptions &options)
+    {
+        Reader r{data, 0, data.size()};
+        if (r.bytes(4) != "WCCP" || r.u32() != CAPTURE_FORMAT)
+            return false;
+        uint32_t wire = r.u32();
+        r.u32();
+        if (r.bad)
+            return false;
+        if ((int)wire != defs.wire_version)
+            out << "warning: captured with wire format v" << wire << ", schema is v" << defs.wire_version << "\n";
+
+        Disassembler d(defs, out, options);
+        std::vector<std::pair<uint32_t, Frame>> frames;
+        while (r.pos < r.end)
+        {
+            uint8_t kind = r.u8();
+            r.pos += std::min<size_t>(3, r.end - r.pos);
+            uint32_t frame = r.u32();
+            if (r.bad)
+                break;
+            if (frames.empty() || frames.back().first != frame)
+            {
+                frames.push_back({frame, Frame{}});
+                if (!options.summary_only)
+                    out << "frame " << frame << "\n";
+            }
+            Frame &f = frames.back().second;
+
+            if (kind == CAPTURE_FLUSH)
+            {
+                uint32_t ptr = r.u32();
+                uint32_t size = r.u32();
+                std::string bytes = r.bytes(size);
+                r.pad4();
+                if (r.bad)
+                    break;
+                d.flush(bytes, ptr, f);
+            }
+            else if (kind == CAPTURE_CALL)
+            {
+                std::string import = r.bytes(r.u32());
+                r.pad4();
+                uint32_t argc = r.u32();
+                std::vector<double> argv;
+                for (uint32_t i = 0; i < argc && !r.bad; ++i)
+                    argv.push_back(r.f64());
+                // String args travel as (ptr, len); show the text instead.
+                std::map<uint32_t, std::string> spans;
+                uint32_t count = r.u32();
+                for (uint32_t i = 0; i < count && !r.bad; ++i)
+                {
+                    uint32_t sp = r.u32();
+                    std::string s = r.bytes(r.u32());
+                    r.pad4();
+                    spans[sp] = s;
+                }
+                if (r.bad)
+                    break;
+                std::string args;
+                for (size_t i = 0; i < argv.size(); ++i)
+                {
+                    if (!args.empty())
+                        args += ", ";
+                    auto it = spans.find((uint32_t)argv[i]);
+                    if (it != spans.end() && i + 1 < argv.size() && argv[i + 1] == it->second.size())
+                    {
+                        args += quote(it->second);
+                        ++i;
+                    }
+                    else
+                        args += number(argv[i]);
+                }
+                d.call(call_name(defs, import), args, f);
+            }
+            else
+            {
+                out << "?? unknown record kind " << (int)kind << "; stopping\n";
+                break;
+            }
+        }
+        if (r.bad)
+            out << "?? capture truncated\n";
+        d.summary(frames);
+        return true;
+    }
+
+    int run_disasm(int argc, char **argv)
+    {
+        std::string defs_path;
+        std::string capture_path;
+        DisasmOptions options;
+        for (int i = 0; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg == "--defs" && i + 1 < argc)
+                defs_path = argv[++i];
+            else if (arg == "--summary")
+                options.summary_only = true;
+            else
+                capture_path = arg;
+        }
+        if (capture_path.empty())
+        {
+            std::cerr << "Usage: webcc disasm [--defs <schema.def>] [--summary] <capture.wccp>" << std::endl;
+            return 1;
+        }
+
+        std::string data = read_file(capture_path);
+        if (data.empty())
+        {
+            std::cerr << "[WebCC] Error: Could not read " << capture_path << std::endl;
+            return 1;
+        }
+        // Same schema lookup as a build: the binary cache next to the
+        // executable, unless a definitions file is named.
+        SchemaDefs defs = defs_path.empty()
+                              ? load_defs_cached(get_executable_dir() + "/schema.wcc.bin", "schema.def")
+                              : load_defs(defs_path);
+        if (!disasm_capture(defs, data, std::cout, options))
+        {
+            std::cerr << "[WebCC] Error: " << capture_path << " is not a webcc capture" << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+} // namespace webcc
@@ -0,0 +1,43 @@
+#pragma once
+#include "schema.h"
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace webcc
+{
+
+    // Command-stream capture, written by an app built with `webcc --capture`
+    // (webcc_capture() / webcc_capture_download() in app.js). All integers are
+    // little-endian; byte runs are zero-padded to 4.
+    //
+    //   header:  "WCCP" | u32 format (1) | u32 wire version | u32 0
+    //   flush:   u8 1, 3 pad | u32 frame | u32 ptr | u32 size | bytes
+    //   call:    u8 2, 3 pad | u32 frame | u32 name len | name
+    //            | u32 argc | f64 args[argc]
+    //            | u32 spans | { u32 ptr | u32 len | bytes } per string arg
+    //
+    // A flush record is exactly what webcc_js_flush() was handed, at the
+    // address it was handed (v1 doubles are aligned by address). A call record
+    // is a return-value import (webcc_<ns>_<func>) with the memory its string
+    // arguments pointed at. `frame` counts animation frames since start-up.
+    constexpr uint32_t CAPTURE_FORMAT = 1;
+    constexpr uint8_t CAPTURE_FLUSH = 1;
+    constexpr uint8_t CAPTURE_CALL = 2;
+
+    struct DisasmOptions
+    {
+        bool summary_only = false; // skip the per-command listing
+    };
+
+    // Decodes a capture with the schema it was built from: each frame's
+    // flushes command by command, then per-frame size statistics and the
+    // commands that sent the most bytes. Returns false if `data` is not a
+    // capture; a stream that stops making sense mid-flush is reported inline.
+    bool disasm_capture(const SchemaDefs &defs, const std::string &data, std::ostream &out,
+                        const DisasmOptions &options = {});
+
+    // `webcc disasm [--defs <path>] [--summary] <capture.wccp>`
+    int run_disasm(int argc, char **argv);
+
+} // namespace webcc
@@ -1,11 +1,15 @@
 #include "generators.h"
 #include "utils.h"
 #include "js_templates.h"
+#include "command_buffer.h"
+#include "event_buffer.h"
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <vector>
 #include <cctype>
 #include <cstdio>
+#include <cstring>
 #include <set>
 #include <map>
 #include <regex>
@@ -142,6 +146,146 @@ namespace webcc
         std::cout << "[WebCC] Emitted include/webcc/core/handles.h with " << handle_types.size() << " typed handles" << std::endl;
     }
 
+    // Emit wire.h: the wire format as a constant, for the hand-written encoders
+    // of built-in commands (e.g. intern()).
+    static void emit_wire_header(int wire_version)
+    {
+        CodeWriter w;
+        w.write("// GENERATED FILE - DO NOT EDIT");
+        w.write("#pragma once");
+        w.write("");
+        w.write("namespace webcc {");
+        w.write("");
+        w.write("// Command wire format selected by schema.def (meta|wire): 1 = aligned");
+        w.write("// 4-byte fields, 2 = compact. Lets hand-written encoders (e.g. intern())");
+        w.write("// match the generated wrappers.");
+        w.write("constexpr int WIRE_VERSION = " + std::to_string(wire_version) + ";");
+        w.write("");
+        w.write("} // namespace webcc");
+        write_file("include/webcc/core/wire.h", w.str());
+    }
+
+    // Worst-case encoded size of a void command, excluding the variable part
+    // of its string params. In the v1 format a double costs up to 4 bytes of
+    // padding depending on where the command lands in the buffer, so the
+    // layout is walked from both possible start offsets (mod 8) and the larger
+    // result wins. After a string the offset parity is unknown and the next
+    // double is charged its padding unconditionally. The compact format has
+    // no padding; a bound command reserves room for a possible BIND.
+    size_t encoded_size(const SchemaCommand &c)
+    {
+        if (c.compact)
+        {
+            size_t size = 1 + (c.bind_slot >= 0 ? BIND_SIZE : 0);
+            for (size_t i = (c.bind_slot >= 0 ? 1 : 0); i < c.params.size(); ++i)
+            {
+                const auto &p = c.params[i];
+                if (p.type == "uint8")
+                    size += 1;
+                else if (p.type == "float64" && !c.narrow_floats)
+                    size += 8;
+                else
+                    size += 4; // 32-bit values and string length prefixes
+            }
+            return size;
+        }
+
+        size_t worst = 0;
+        for (int start : {0, 4})
+        {
+            size_t size = 4; // opcode
+            int parity = (start + 4) % 8; // -1 once unknown
+            for (const auto &p : c.params)
+            {
+                if (p.type == "float64" && !c.narrow_floats)
+                {
+                    size += (parity == 0 ? 0 : 4) + 8;
+                    parity = 0;
+                }
+                else if (p.type == "string")
+                {
+                    size += 4; // length prefix
+                    parity = -1;
+                }
+                else
+                {
+                    size += 4;
+                    if (parity >= 0)
+                        parity ^= 4;
+                }
+            }
+            worst = std::max(worst, size);
+        }
+        return worst;
+    }
+
+    // MOUSE_MOVE -> MouseMoveEvent
+    static std::string event_struct_name(const std::string &name)
+    {
+        std::string struct_name;
+        bool next_upper = true;
+        for (char c : name)
+        {
+            if (c == '_')
+            {
+                next_upper = true;
+            }
+            else
+            {
+                if (next_upper)
+                {
+                    struct_name += toupper(c);
+                    next_upper = false;
+                }
+                else
+                {
+                    struct_name += tolower(c);
+                }
+            }
+        }
+        return struct_name + "Event";
+    }
+
+    // include/webcc/events.h: webcc::dispatch_events() over every event in the
+    // schema. Event opcodes are unique across namespaces, so one switch covers
+    // them all.
+    static void emit_events_header(const SchemaDefs &defs)
+    {
+        CodeWriter w;
+        w.write("// GENERATED FILE - DO NOT EDIT");
+        w.write("#pragma once");
+        std::set<std::string> namespaces;
+        for (const auto &d : defs.events)
+            namespaces.insert(d.ns);
+        for (const auto &ns : namespaces)
+            w.write("#include \"" + ns + ".h\"");
+        w.write("namespace webcc {");
+        w.write("// Polls every pending event and calls the handler overload that takes its");
+        w.write("// struct, or one taking `const webcc::Event&` for the rest. Handlers are");
+        w.write("// copied, so capture state by reference:");
+        w.write("//   webcc::dispatch_events(");
+        w.write("//       [&](const webcc::input::MouseMoveEvent& e) { x = e.x; },");
+        w.write("//       [&](const webcc::dom::ClickEvent& e) { clicked(e.handle); });");
+        w.write("template <typename... Handlers>");
+        w.write("inline void dispatch_events(Handlers... handlers) {");
+        w.write("webcc::overloaded<Handlers...> h{handlers...};");
+        w.write("webcc::Event e;");
+        w.write("while (webcc::poll_event(e)) {");
+        w.write("switch (e.opcode) {");
+        for (const auto &d : defs.events)
+        {
+            std::string ns = "webcc::" + d.ns + "::";
+            w.write("case " + ns + "EVENT_" + d.name + ": webcc::detail::dispatch_event<" + ns + event_struct_name(d.name) + ">(h, e); break;");
+        }
+        w.write("default: webcc::detail::dispatch_other(h, e); break;");
+        w.write("}");
+        w.write("}");
+        w.write("}");
+        w.write("} // namespace webcc");
+        write_file("include/webcc/events.h", w.str());
+        std::cout << "[WebCC] Emitted include/webcc/events.h" << std::endl;
+    }
+
     void emit_headers(const SchemaDefs &defs)
     {
         std::cout << "[WebCC] Emitting headers..." << std::endl;
@@ -162,6 +306,7 @@ namespace webcc
         {
             emit_handles_header(handle_types, defs.handle_inheritance);
         }
+        emit_wire_header(defs.wire_version);
 
         // Emit per-namespace headers
         std::set<std::string> namespaces;
@@ -188,6 +333,7 @@ namespace webcc
             }
             w.write("#include \"webcc/core/string_view.h\"");
             w.write("#include \"webcc/core/string.h\"");
+            w.write("#include \"webcc/core/intern.h\"");
             w.write("namespace webcc::" + ns + " {");
 
             // Commands
@@ -204,6 +350,17 @@ namespace webcc
             w.write("};");
             w.write("");
 
+            // The namespace's opcodes, for webcc::stats (Counters::sum).
+            std::string opcodes;
+            for (const auto &d : defs.commands)
+                if (d.ns == ns)
+                    opcodes += (opcodes.empty() ? "OP_" : ", OP_") + d.name;
+            if (!opcodes.empty())
+            {
+                w.write("constexpr uint8_t OPCODES[] = {" + opcodes + "};");
+                w.write("");
+            }
+
             // Events
             bool has_events = false;
             for (const auto &d : defs.events)
@@ -236,34 +393,63 @@ namespace webcc
                 w.write("};");
                 w.write("");
 
+                // Mask bit -> opcode. Every event is on until unsubscribed;
+                // JS then drops it before encoding anything.
+                std::string event_opcodes;
+                for (const auto &d : defs.events)
+                    if (d.ns == ns)
+                        event_opcodes += (event_opcodes.empty() ? "EVENT_" : ", EVENT_") + d.name;
+                w.write("constexpr uint8_t EVENT_OPCODES[] = {" + event_opcodes + "};");
+                w.write("inline void subscribe(uint32_t mask) {");
+                w.write("for (uint32_t i = 0; i < sizeof(EVENT_OPCODES); ++i) {");
+                w.write("if (mask & (1u << i)) webcc::subscribe_event(EVENT_OPCODES[i]);");
+                w.write("}");
+                w.write("}");
+                w.write("inline void unsubscribe(uint32_t mask) {");
+                w.write("for (uint32_t i = 0; i < sizeof(EVENT_OPCODES); ++i) {");
+                w.write("if (mask & (1u << i)) webcc::unsubscribe_event(EVENT_OPCODES[i]);");
+                w.write("}");
+                w.write("}");
+                w.write("");
+
                 // Generate Event Structs
                 for (const auto &d : defs.events)
                 {
                     if (d.ns != ns)
                         continue;
 
-                    std::string struct_name;
-                    bool next_upper = true;
-                    for (char c : d.name)
+                    std::string struct_name = event_struct_name(d.name);
+
+                    if (d.batch)
                     {
-                        if (c == '_')
+                        // A block of `count` samples, one column per param,
+                        // read in place from the ring.
+                        w.write("struct " + struct_name + " {");
+                        w.write("static constexpr uint8_t OPCODE = EVENT_" + d.name + ";");
+                        w.write("static constexpr uint32_t CAPACITY = " + std::to_string(d.batch) + ";");
+                        w.write("uint32_t count;");
+                        // Columns are plain numbers: no handle types by name.
+                        for (const auto &p : d.params)
+                            w.write("const " + map_cpp_type(p.type, "") + "* " + p.name + ";");
+                        w.write("");
+                        w.write("static " + struct_name + " parse(const uint8_t* data, uint32_t len) {");
+                        w.write(struct_name + " res;");
+                        w.write("uint32_t offset = 0;");
+                        w.write("res.count = *(uint32_t*)(data + offset); offset += 4;");
+                        for (const auto &p : d.params)
                         {
-                            next_upper = true;
-                        }
-                        else
-                        {
-                            if (next_upper)
-                            {
-                                struct_name += toupper(c);
-                                next_upper = false;
-                            }
-                            else
-                            {
-                                struct_name += tolower(c);
-                            }
+                            std::string cpp_type = map_cpp_type(p.type, "");
+                            if (p.type == "float64")
+                                w.write("{ uintptr_t addr = (uintptr_t)(data + offset); offset = ((addr + 7) & ~7) - (uintptr_t)data; }");
+                            w.write("res." + p.name + " = (const " + cpp_type + "*)(data + offset); offset += " +
+                                    std::to_string((p.type == "float64" ? 8 : 4) * d.batch) + ";");
                         }
+                        w.write("return res;");
+                        w.write("}");
+                        w.write("};");
+                        w.write("");
+                        continue;
                     }
-                    struct_name += "Event";
 
                     w.write("struct " + struct_name + " {");
                     w.write("static constexpr uint8_t OPCODE = EVENT_" + d.name + ";");
@@ -316,9 +502,15 @@ namespace webcc
                         }
                         else if (p.type == "string")
                         {
+                            // Long strings come out of band (see event_buffer.h).
                             w.write("uint32_t " + p.name + "_len = *(uint32_t*)(data + offset); offset += 4;");
+                            w.write("if (" + p.name + "_len & webcc::EVENT_DETACHED) {");
+                            w.write("res." + p.name + " = webcc::string_view((const char*)(uintptr_t)*(uint32_t*)(data + offset), " + p.name + "_len & ~webcc::EVENT_DETACHED);");
+                            w.write("offset += 4;");
+                            w.write("} else {");
                             w.write("res." + p.name + " = webcc::string_view((const char*)(data + offset), " + p.name + "_len);");
                             w.write("offset += (" + p.name + "_len + 3) & ~3;");
+                            w.write("}");
                         }
                     }
                     w.write("return res;");
@@ -410,7 +602,7 @@ namespace webcc
                     }
                     wrap << "){";
                     w.write(wrap.str());
-                    w.write("::webcc::flush();");
+                    w.write("::webcc::detail::flush_for(::webcc::FlushReason::Getter);");
 
                     std::stringstream call;
                     if (ret_type == "string")
@@ -515,6 +707,11 @@ namespace webcc
                     {
                         func << t_params[t_idx++] << " " << name;
                     }
+                    else if (p.type == "string")
+                    {
+                        // Buffered strings may also be interned ids (see intern.h).
+                        func << "webcc::string_arg " << name;
+                    }
                     else
                     {
                         func << map_cpp_type(p.type, p.name, p.handle_type) << " " << name;
@@ -523,33 +720,57 @@ namespace webcc
                 func << "){";
                 w.write(func.str());
                 w.write("[[maybe_unused]] static void (*const __webcc_keep)(void) __attribute__((used)) = &__webcc_m_" + mark_op + ";");
-                w.write("push_command((uint32_t)OP_" + d.name + ");");
+                // One capacity check for the whole command, then unchecked
+                // stores: the fixed part is known here, strings add their
+                // padded length at run time.
+                std::string reserve = std::to_string(encoded_size(d));
                 for (size_t i = 0; i < d.params.size(); ++i)
+                {
+                    if (d.params[i].type != "string")
+                        continue;
+                    std::string name = d.params[i].name.empty() ? ("arg" + std::to_string(i)) : d.params[i].name;
+                    if (d.compact)
+                        reserve += " + " + name + ".length()";
+                    else
+                        reserve += " + webcc::CommandCursor::pad4(" + name + ".length())";
+                }
+                w.write("webcc::CommandCursor _cmd = webcc::CommandBuffer::reserve(" + reserve + ");");
+                w.write("if (!_cmd) return;");
+                if (d.bind_slot >= 0)
+                {
+                    std::string name = d.params[0].name.empty() ? "arg0" : d.params[0].name;
+                    w.write("_cmd.bind(" + std::to_string(d.bind_slot) + ", (int32_t)" + name + ");");
+                }
+                w.write(std::string(d.compact ? "_cmd.u8(" : "_cmd.u32(") + "OP_" + d.name + ");");
+                for (size_t i = (d.bind_slot >= 0 ? 1 : 0); i < d.params.size(); ++i)
                 {
                     const auto &p = d.params[i];
                     std::string name = p.name.empty() ? ("arg" + std::to_string(i)) : p.name;
                     std::string cpp_type = map_cpp_type(p.type, p.name, p.handle_type);
 
                     if (cpp_type == "webcc::string_view")
-                        w.write("webcc::CommandBuffer::push_string(" + name + ".data(), " + name + ".length());");
+                        w.write(std::string(d.compact ? "_cmd.str_packed(" : "_cmd.str(") + name + ".data(), " + name + ".length(), " + name + ".ref());");
                     else if (cpp_type.find("webcc::") != std::string::npos && cpp_type != "webcc::string_view")
                         // Any handle type (typed or untyped)
-                        w.write("push_data<int32_t>((int32_t)" + name + ");");
+                        w.write("_cmd.i32((int32_t)" + name + ");");
                     else if (p.type == "uint8")
-                        w.write("push_data<uint32_t>((uint32_t)" + name + ");");
+                        w.write(d.compact ? "_cmd.u8(" + name + ");" : "_cmd.u32((uint32_t)" + name + ");");
                     else if (p.type == "uint32")
-                        w.write("push_data<uint32_t>(" + name + ");");
+                        w.write("_cmd.u32(" + name + ");");
                     else if (p.type == "int32")
-                        w.write("push_data<int32_t>(" + name + ");");
+                        w.write("_cmd.i32(" + name + ");");
                     else if (p.type == "float32")
-                        w.write("push_data<float>(" + name + ");");
+                        w.write("_cmd.f32(" + name + ");");
+                    else if (p.type == "float64" && d.narrow_floats)
+                        w.write("_cmd.f32((float)" + name + ");");
                     else if (p.type == "float64")
-                        w.write("push_data<double>(" + name + ");");
+                        w.write(std::string(d.compact ? "_cmd.f64_packed(" : "_cmd.f64(") + name + ");");
                     else if (p.type == "func_ptr")
-                        w.write("push_data<uint32_t>((uint32_t)(uintptr_t)" + name + ");");
+                        w.write("_cmd.u32((uint32_t)(uintptr_t)" + name + ");");
                     else
                         w.write("// unknown type: " + p.type);
                 }
+                w.write("webcc::CommandBuffer::commit(_cmd);");
                 w.write("}");
                 w.write("");
             }
@@ -559,55 +780,439 @@ namespace webcc
             std::cout << "[WebCC] Emitted include/webcc/" << ns << ".h" << std::endl;
         }
         
+        if (!defs.events.empty())
+            emit_events_header(defs);
+
         // Save binary cache for fast runtime loading (no need to recompile webcc)
         save_defs_binary(defs, "schema.wcc.bin");
     }
 
-    void gen_js_case(const SchemaCommand &c, CodeWriter &w)
+    // Statement that abandons a command whose fields run past `end`. In the
+    // switch, debug builds leave the case and release builds the whole batch;
+    // a table-dispatched handler returns `end`, which ends the batch too.
+    static std::string js_bail(const JsCaseOptions &opts)
+    {
+        if (opts.table_dispatch)
+            return "return end;";
+        return opts.release ? "return;" : "break;";
+    }
+
+    static std::string js_case_open(int opcode, const std::string &name, bool compact, const JsCaseOptions &opts)
+    {
+        if (!opts.table_dispatch)
+            return "case " + std::to_string(opcode) + ": {";
+        return std::string("function op_") + name + (compact ? "(u8, dv, pos, end) {" : "(u8, i32, f32, f64, pos, end) {");
+    }
+
+    static std::string js_case_close(const JsCaseOptions &opts)
+    {
+        return opts.table_dispatch ? "return pos;" : "break;";
+    }
+
+    // Whether `js` assigns to an element of `map` (e.g. `elements[h] = el`).
+    static bool js_writes_map(const std::string &js, const std::string &map)
+    {
+        for (size_t at = js.find(map + "["); at != std::string::npos; at = js.find(map + "[", at + 1))
+        {
+            if (at > 0 && (std::isalnum((unsigned char)js[at - 1]) || js[at - 1] == '_' || js[at - 1] == '.'))
+                continue;
+            size_t close = js.find(']', at);
+            if (close == std::string::npos)
+                break;
+            size_t k = close + 1;
+            while (k < js.size() && js[k] == ' ')
+                ++k;
+            if (k + 1 < js.size() && js[k] == '=' && js[k + 1] != '=')
+                return true;
+        }
+        return false;
+    }
+
+    // Rewrites `map[ident]` reads into `map_at(ident)`, the cached lookup the
+    // table-dispatch runtime defines for the maps in JS_CACHED_MAPS.
+    static std::string js_cache_map_reads(const std::string &js, const std::string &map)
+    {
+        std::string out;
+        size_t i = 0;
+        for (size_t at = js.find(map + "[", i); at != std::string::npos; at = js.find(map + "[", i))
+        {
+            size_t open = at + map.size();
+            size_t close = js.find(']', open);
+            bool word_start = at == 0 || !(std::isalnum((unsigned char)js[at - 1]) || js[at - 1] == '_' || js[at - 1] == '.');
+            bool ident = close != std::string::npos && close > open + 1;
+            for (size_t k = open + 1; ident && k < close; ++k)
+                ident = std::isalnum((unsigned char)js[k]) || js[k] == '_';
+            if (!word_start || !ident)
+            {
+                out.append(js, i, open + 1 - i);
+                i = open + 1;
+                continue;
+            }
+            out.append(js, i, at - i);
+            out += map + "_at(" + js.substr(open + 1, close - open - 1) + ")";
+            i = close + 1;
+        }
+        out.append(js, i, std::string::npos);
+        return out;
+    }
+
+    const std::vector<std::string> JS_CACHED_MAPS = {"contexts", "elements"};
+
+    // Whether `js` may contain a loop of its own, so that a `continue` in it
+    // need not be a bail-out from the command. Errs towards true.
+    static bool js_has_loop(const std::string &js)
+    {
+        for (const char *kw : {"for", "while", "do"})
+        {
+            size_t n = std::strlen(kw);
+            for (size_t at = js.find(kw); at != std::string::npos; at = js.find(kw, at + 1))
+            {
+                bool starts = at == 0 || !(std::isalnum((unsigned char)js[at - 1]) || js[at - 1] == '_' || js[at - 1] == '.');
+                bool ends = at + n == js.size() || !(std::isalnum((unsigned char)js[at + n]) || js[at + n] == '_');
+                if (starts && ends)
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    // Writes a command's action and closes its case. With table dispatch the
+    // action runs inside a function: `continue` (skip to the next command)
+    // becomes `return pos`, and reads of the cached maps go through the
+    // last-handle cache, which actions that write the map invalidate. An
+    // action with loops of its own is instead wrapped in a one-pass
+    // `do { } while (false)`, so each `continue` keeps its meaning: inside a
+    // loop it continues that loop, at the top level it leaves the action.
+    static void write_js_action(CodeWriter &w, const JsCaseOptions &opts, std::string action)
+    {
+        if (!opts.table_dispatch)
+        {
+            w.write(action);
+            w.write(js_case_close(opts));
+            w.write("}");
+            return;
+        }
+        if (js_has_loop(action))
+            action = "do { " + action + " } while (false);";
+        else
+            for (size_t at = action.find("continue;"); at != std::string::npos; at = action.find("continue;", at))
+                action.replace(at, 9, "return pos;");
+        std::string invalidate;
+        for (const auto &map : JS_CACHED_MAPS)
+        {
+            if (js_writes_map(action, map))
+                invalidate += map + "_h = -1; ";
+            else
+                action = js_cache_map_reads(action, map);
+        }
+        w.write(action);
+        if (!invalidate.empty())
+            w.write(invalidate.substr(0, invalidate.size() - 1));
+        w.write(js_case_close(opts));
+        w.write("}");
+        w.write("");
+    }
+
+    // Compact (v2) decoding: values are unaligned, so everything wider than a
+    // byte goes through the DataView.
+    static void gen_js_param_compact(const SchemaCommand &c, size_t i, CodeWriter &w, const JsCaseOptions &opts)
     {
-        w.write("case " + std::to_string((int)c.opcode) + ": {");
+        const auto &p = c.params[i];
+        std::string varName = p.name.empty() ? ("arg" + std::to_string(i)) : p.name;
+        if ((int)i == 0 && c.bind_slot >= 0)
+        {
+            w.write("const " + varName + " = bound[" + std::to_string(c.bind_slot) + "];");
+        }
+        else if (p.type == "uint8")
+        {
+            w.write("if (pos + 1 > end) { console.error('WebCC: OOB " + varName + "'); " + js_bail(opts) + " }");
+            w.write("const " + varName + " = u8[pos]; pos += 1;");
+        }
+        else if (p.type == "uint32" || p.type == "int32" || p.type == "func_ptr" || p.type == "handle")
+        {
+            w.write("if (pos + 4 > end) { console.error('WebCC: OOB " + varName + "'); " + js_bail(opts) + " }");
+            w.write("const " + varName + " = dv.getInt32(pos, true); pos += 4;");
+        }
+        else if (p.type == "float32" || (p.type == "float64" && c.narrow_floats))
+        {
+            w.write("if (pos + 4 > end) { console.error('WebCC: OOB " + varName + "'); " + js_bail(opts) + " }");
+            w.write("const " + varName + " = dv.getFloat32(pos, true); pos += 4;");
+        }
+        else if (p.type == "float64")
+        {
+            w.write("if (pos + 8 > end) { console.error('WebCC: OOB " + varName + "'); " + js_bail(opts) + " }");
+            w.write("const " + varName + " = dv.getFloat64(pos, true); pos += 8;");
+        }
+        else if (p.type == "string")
+        {
+            w.write("if (pos + 4 > end) { console.error('WebCC: OOB " + varName + "_len'); " + js_bail(opts) + " }");
+            if (opts.interned_strings)
+            {
+                // A negative length is INTERNED_BIT | id: no bytes follow.
+                w.write("const " + varName + "_len = dv.getInt32(pos, true); pos += 4;");
+                w.write("const " + varName + "_bytes = " + varName + "_len < 0 ? 0 : " + varName + "_len;");
+                w.write("if (pos + " + varName + "_bytes > end) { console.error('WebCC: OOB " + varName + "_data'); " + js_bail(opts) + " }");
+                w.write("const " + varName + " = " + varName + "_len < 0 ? interned_strings[" + varName + "_len & 0x7FFFFFFF] : decoder.decode(u8.subarray(pos, pos + " + varName + "_len)); pos += " + varName + "_bytes;");
+                return;
+            }
+            w.write("const " + varName + "_len = dv.getUint32(pos, true); pos += 4;");
+            w.write("if (pos + " + varName + "_len > end) { console.error('WebCC: OOB " + varName + "_data'); " + js_bail(opts) + " }");
+            w.write("const " + varName + " = decoder.decode(u8.subarray(pos, pos + " + varName + "_len)); pos += " + varName + "_len;");
+        }
+        else
+        {
+            w.write("// Unknown type: " + p.type);
+        }
+    }
+
+    std::string strip_js_diagnostics(const std::string &js)
+    {
+        std::string out;
+        size_t i = 0;
+        while (i < js.size())
+        {
+            size_t call = std::string::npos;
+            size_t args = 0;
+            for (const char *fn : {"console.warn(", "console.error("})
+            {
+                size_t at = js.find(fn, i);
+                if (at != std::string::npos && at < call)
+                {
+                    call = at;
+                    args = at + std::strlen(fn);
+                }
+            }
+            if (call == std::string::npos)
+                break;
+
+            size_t first = args;
+            while (first < js.size() && std::isspace((unsigned char)js[first]))
+                ++first;
+            if (first >= js.size() || (js[first] != '\'' && js[first] != '"' && js[first] != '`'))
+            {
+                // Logs a runtime value (e.g. system::warn): user output, keep it.
+                out.append(js, i, args - i);
+                i = args;
+                continue;
+            }
+
+            // Find the closing paren, skipping string literals and nested calls.
+            size_t j = args;
+            int depth = 1;
+            char quote = 0;
+            for (; j < js.size() && depth > 0; ++j)
+            {
+                char ch = js[j];
+                if (quote)
+                {
+                    if (ch == '\\')
+                        ++j;
+                    else if (ch == quote)
+                        quote = 0;
+                }
+                else if (ch == '\'' || ch == '"' || ch == '`')
+                    quote = ch;
+                else if (ch == '(')
+                    ++depth;
+                else if (ch == ')')
+                    --depth;
+            }
+            if (depth > 0)
+                break; // unbalanced; leave the rest untouched
+
+            // A whole statement is dropped. Anywhere else (an arrow body, an
+            // unbraced `if`) the call becomes `0` so the code stays valid.
+            size_t prev = call;
+            while (prev > 0 && std::isspace((unsigned char)js[prev - 1]))
+                --prev;
+            bool statement = prev == 0 || js[prev - 1] == '{' || js[prev - 1] == ';' || js[prev - 1] == '}';
+            out.append(js, i, call - i);
+            if (statement)
+            {
+                while (j < js.size() && js[j] == ' ')
+                    ++j;
+                if (j < js.size() && js[j] == ';')
+                    ++j;
+                while (j < js.size() && js[j] == ' ')
+                    ++j;
+            }
+            else
+                out += "0";
+            i = j;
+        }
+        out.append(js, i, std::string::npos);
+        return out;
+    }
+
+    // Release decoding (JsCaseOptions::release). The params are split into
+    // segments that each end with a string's length prefix (or the last
+    // param); one check covers a whole segment, so a command without strings
+    // is checked once. In the v1 format a double's padding depends on where
+    // the segment starts (mod 8), so its size may be a run-time choice.
+    static void gen_js_case_release(const SchemaCommand &c, CodeWriter &w, const JsCaseOptions &opts)
+    {
+        auto name_of = [&](size_t i)
+        {
+            return c.params[i].name.empty() ? ("arg" + std::to_string(i)) : c.params[i].name;
+        };
+        // Fixed size of params [from, to) starting at an offset with the given
+        // parity (mod 8).
+        auto segment_size = [&](size_t from, size_t to, int parity)
+        {
+            size_t size = 0;
+            for (size_t i = from; i < to; ++i)
+            {
+                const auto &p = c.params[i];
+                if (c.compact)
+                    size += p.type == "uint8" ? 1 : (p.type == "float64" && !c.narrow_floats) ? 8 : 4;
+                else if (p.type == "float64" && !c.narrow_floats)
+                {
+                    size += (parity ? 4 : 0) + 8;
+                    parity = 0;
+                }
+                else
+                {
+                    size += 4;
+                    parity ^= 4;
+                }
+            }
+            return size;
+        };
+
+        w.write(js_case_open(c.opcode, c.ns + "_" + c.func_name, c.compact, opts));
+        size_t i = 0;
+        if (c.compact && c.bind_slot >= 0)
+        {
+            w.write("const " + name_of(0) + " = bound[" + std::to_string(c.bind_slot) + "];");
+            i = 1;
+        }
+        while (i < c.params.size())
+        {
+            size_t end = i;
+            while (end < c.params.size() && c.params[end].type != "string")
+                ++end;
+            end = std::min(end + 1, c.params.size());
+
+            size_t n0 = segment_size(i, end, 0), n4 = segment_size(i, end, 4);
+            if (c.compact || n0 == n4)
+                w.write("if (pos + " + std::to_string(n0) + " > end) " + js_bail(opts));
+            else
+                w.write("if (pos + ((pos & 4) ? " + std::to_string(n4) + " : " + std::to_string(n0) + ") > end) " + js_bail(opts));
+
+            int parity = -1; // offset mod 8 once the first double has aligned it
+            for (; i < end; ++i)
+            {
+                const auto &p = c.params[i];
+                std::string v = name_of(i);
+                bool wide = p.type == "float64" && !c.narrow_floats;
+                bool real = p.type == "float32" || (p.type == "float64" && c.narrow_floats);
+                if (p.type == "string")
+                {
+                    bool ids = opts.interned_strings;
+                    std::string len = c.compact ? (std::string(ids ? "dv.getInt32" : "dv.getUint32") + "(pos, true)") : "i32[pos >> 2]";
+                    std::string bytes = c.compact ? v + "_len" : "(" + v + "_len + 3) & ~3";
+                    w.write("const " + v + "_len = " + len + "; pos += 4;");
+                    w.write("const " + v + "_bytes = " + (ids ? v + "_len < 0 ? 0 : " : "") + bytes + ";");
+                    w.write("if (pos + " + v + "_bytes > end) " + js_bail(opts));
+                    std::string text = "decoder.decode(u8.subarray(pos, pos + " + v + "_len))";
+                    if (ids)
+                        text = v + "_len < 0 ? interned_strings[" + v + "_len & 0x7FFFFFFF] : " + text;
+                    w.write("const " + v + " = " + text + "; pos += " + v + "_bytes;");
+                }
+                else if (c.compact)
+                {
+                    if (p.type == "uint8")
+                        w.write("const " + v + " = u8[pos]; pos += 1;");
+                    else if (wide)
+                        w.write("const " + v + " = dv.getFloat64(pos, true); pos += 8;");
+                    else if (real)
+                        w.write("const " + v + " = dv.getFloat32(pos, true); pos += 4;");
+                    else
+                        w.write("const " + v + " = dv.getInt32(pos, true); pos += 4;");
+                }
+                else if (wide)
+                {
+                    if (parity < 0)
+                        w.write("pos += pos & 4;");
+                    else if (parity == 4)
+                        w.write("pos += 4;");
+                    w.write("const " + v + " = f64[pos >> 3]; pos += 8;");
+                    parity = 0;
+                }
+                else
+                {
+                    w.write("const " + v + " = " + (real ? "f32" : "i32") + "[pos >> 2]; pos += 4;");
+                    if (parity >= 0)
+                        parity ^= 4;
+                }
+            }
+        }
+        write_js_action(w, opts, strip_js_diagnostics(c.action));
+    }
+
+    void gen_js_case(const SchemaCommand &c, CodeWriter &w, const JsCaseOptions &opts)
+    {
+        if (opts.release)
+        {
+            gen_js_case_release(c, w, opts);
+            return;
+        }
+        w.write(js_case_open(c.opcode, c.ns + "_" + c.func_name, c.compact, opts));
         // Declare typed variables using the parameter names from the def file
         for (size_t i = 0; i < c.params.size(); ++i)
         {
+            if (c.compact)
+            {
+                gen_js_param_compact(c, i, w, opts);
+                continue;
+            }
             const auto &p = c.params[i];
             std::string varName = p.name.empty() ? ("arg" + std::to_string(i)) : p.name;
             if (p.type == "uint8" || p.type == "uint32")
             {
-                w.write("if (pos + 4 > end) { console.error('WebCC: OOB " + varName + "'); break; }");
+                w.write("if (pos + 4 > end) { console.error('WebCC: OOB " + varName + "'); " + js_bail(opts) + " }");
                 w.write("const " + varName + " = i32[pos >> 2]; pos += 4;");
             }
             else if (p.type == "int32")
             {
-                w.write("if (pos + 4 > end) { console.error('WebCC: OOB " + varName + "'); break; }");
+                w.write("if (pos + 4 > end) { console.error('WebCC: OOB " + varName + "'); " + js_bail(opts) + " }");
                 w.write("const " + varName + " = i32[pos >> 2]; pos += 4;");
             }
-            else if (p.type == "float32")
+            else if (p.type == "float32" || (p.type == "float64" && c.narrow_floats))
             {
-                w.write("if (pos + 4 > end) { console.error('WebCC: OOB " + varName + "'); break; }");
+                w.write("if (pos + 4 > end) { console.error('WebCC: OOB " + varName + "'); " + js_bail(opts) + " }");
                 w.write("const " + varName + " = f32[pos >> 2]; pos += 4;");
             }
             else if (p.type == "float64")
             {
                 w.write("if (pos % 8 !== 0) pos += (8 - (pos % 8));");
-                w.write("if (pos + 8 > end) { console.error('WebCC: OOB " + varName + "'); break; }");
+                w.write("if (pos + 8 > end) { console.error('WebCC: OOB " + varName + "'); " + js_bail(opts) + " }");
                 w.write("const " + varName + " = f64[pos >> 3]; pos += 8;");
             }
             else if (p.type == "func_ptr")
             {
-                w.write("if (pos + 4 > end) { console.error('WebCC: OOB " + varName + "'); break; }");
+                w.write("if (pos + 4 > end) { console.error('WebCC: OOB " + varName + "'); " + js_bail(opts) + " }");
                 w.write("const " + varName + " = i32[pos >> 2]; pos += 4;");
             }
             else if (p.type == "handle")
             {
-                w.write("if (pos + 4 > end) { console.error('WebCC: OOB " + varName + "'); break; }");
+                w.write("if (pos + 4 > end) { console.error('WebCC: OOB " + varName + "'); " + js_bail(opts) + " }");
                 w.write("const " + varName + " = i32[pos >> 2]; pos += 4;");
             }
             else if (p.type == "string")
             {
-                w.write("if (pos + 4 > end) { console.error('WebCC: OOB " + varName + "_len'); break; }");
+                w.write("if (pos + 4 > end) { console.error('WebCC: OOB " + varName + "_len'); " + js_bail(opts) + " }");
                 w.write("const " + varName + "_len = i32[pos >> 2]; pos += 4;");
+                if (opts.interned_strings)
+                {
+                    // A negative length is INTERNED_BIT | id: no bytes follow.
+                    w.write("const " + varName + "_padded = " + varName + "_len < 0 ? 0 : (" + varName + "_len + 3) & ~3;");
+                    w.write("if (pos + " + varName + "_padded > end) { console.error('WebCC: OOB " + varName + "_data'); " + js_bail(opts) + " }");
+                    w.write("const " + varName + " = " + varName + "_len < 0 ? interned_strings[" + varName + "_len & 0x7FFFFFFF] : decoder.decode(u8.subarray(pos, pos + " + varName + "_len)); pos += " + varName + "_padded;");
+                    continue;
+                }
                 w.write("const " + varName + "_padded = (" + varName + "_len + 3) & ~3;");
-                w.write("if (pos + " + varName + "_padded > end) { console.error('WebCC: OOB " + varName + "_data'); break; }");
+                w.write("if (pos + " + varName + "_padded > end) { console.error('WebCC: OOB " + varName + "_data'); " + js_bail(opts) + " }");
                 w.write("const " + varName + " = decoder.decode(u8.subarray(pos, pos + " + varName + "_len)); pos += " + varName + "_padded;");
             }
             else
@@ -615,9 +1220,7 @@ namespace webcc
                 w.write("// Unknown type: " + p.type);
             }
         }
-        w.write(c.action);
-        w.write("break;");
-        w.write("}");
+        write_js_action(w, opts, c.action);
     }
 
     bool contains_whole_word(const std::string &text, const std::string &word)
@@ -708,6 +1311,9 @@ namespace webcc
             "webcc_event_buffer_capacity",
             "webcc_scratch_buffer_ptr",
             "webcc_command_buffer_ptr",
+            "webcc_event_alloc",
+            "webcc_frame_end",
+            "webcc_heap_stats_ptr",
         };
         return exports;
     }
@@ -875,7 +1481,7 @@ namespace webcc
         w.raw("\n        }");
     }
 
-    void generate_js_runtime(const SchemaDefs &defs, const std::set<std::string> &wasm_imports, const std::set<std::string> &void_markers, const std::set<std::string> &inline_js_fns, const std::string &out_dir)
+    void generate_js_runtime(const SchemaDefs &defs, const std::set<std::string> &wasm_imports, const std::set<std::string> &void_markers, const std::set<std::string> &inline_js_fns, const std::string &out_dir, const JsRuntimeOptions &options)
     {
         CodeWriter w;
 
@@ -887,8 +1493,33 @@ namespace webcc
         std::set<std::string> used_event_helpers;   // Track which push_event helpers must exist
         std::vector<std::string> generated_js_imports;
         bool any_void_command_used = false; // whether any void command (and thus marker import) is used
+        bool any_bound_command_used = false; // compact format: whether the BIND built-in must be decoded
+        // intern() leaves the INTERN built-in's marker; only then can string
+        // params carry ids, so only then is the id branch emitted.
+        JsCaseOptions case_opts;
+        const bool release = options.release;
+        case_opts.release = release;
+        case_opts.table_dispatch = options.dispatch == JsDispatch::Table;
+        case_opts.interned_strings = void_markers.count(std::to_string((int)OP_INTERN)) > 0;
+        if (case_opts.interned_strings)
+            any_void_command_used = true;
+        // Likewise the display-list built-ins (display_list.h) and the recorder.
+        bool display_lists_used = void_markers.count(std::to_string((int)OP_BEGIN_RECORD)) > 0;
+        if (display_lists_used)
+            any_void_command_used = true;
         CodeWriter cases_w;
-        cases_w.set_indent(4);
+        // Switch cases sit inside exec(); table handlers are top-level functions.
+        cases_w.set_indent(case_opts.table_dispatch ? 1 : 4);
+        // Guard for a built-in case's fixed-size payload.
+        auto bounds_check = [&](int bytes, const std::string &what)
+        {
+            std::string cond = "if (pos + " + std::to_string(bytes) + " > end) ";
+            return release ? cond + js_bail(case_opts) : cond + "{ console.error('WebCC: OOB " + what + "'); " + js_bail(case_opts) + " }";
+        };
+        // (opcode, handler suffix) of every op_<name> handler, for --dispatch=table.
+        std::vector<std::pair<int, std::string>> table_entries;
+        // opcode -> "ns.command" for the --stats report.
+        std::map<int, std::string> op_names;
 
         // Detect which commands are used entirely from the linked module's
         // import table -- no source scanning. Both kinds of command leave an
@@ -934,6 +1565,28 @@ namespace webcc
                     }
                     ss << ") => {\n";
 
+                    // --capture: log the call, and the bytes its strings point at.
+                    if (options.capture)
+                    {
+                        std::string args, strings;
+                        size_t slot = 0;
+                        for (size_t i = 0; i < d.params.size(); ++i, ++slot)
+                        {
+                            const auto &p = d.params[i];
+                            std::string name = p.name.empty() ? ("arg" + std::to_string(i)) : p.name;
+                            if (!args.empty())
+                                args += ", ";
+                            if (p.type == "string")
+                            {
+                                strings += (strings.empty() ? "" : ", ") + std::to_string(slot++);
+                                args += name + "_ptr, " + name + "_len";
+                            }
+                            else
+                                args += name;
+                        }
+                        ss << "capture_call(\"webcc_" << d.ns << "_" << d.func_name << "\", [" << args << "], [" << strings << "]);\n";
+                    }
+
                     // Decode strings
                     for (size_t i = 0; i < d.params.size(); ++i)
                     {
@@ -946,7 +1599,12 @@ namespace webcc
                     }
 
                     // Strip outer braces if present to expose local variables (like 'ret')
-                    std::string action_body = d.action;
+                    std::string action_body = release ? strip_js_diagnostics(d.action) : d.action;
+                    // Keep the table-dispatch handle caches coherent.
+                    if (case_opts.table_dispatch)
+                        for (const auto &map : JS_CACHED_MAPS)
+                            if (js_writes_map(action_body, map))
+                                ss << map << "_h = -1;\n";
                     size_t open_brace = action_body.find('{');
                     size_t close_brace = action_body.rfind('}');
                     if (open_brace != std::string::npos && close_brace != std::string::npos && close_brace > open_brace)
@@ -969,8 +1627,12 @@ namespace webcc
                     // For commands without a return value, generate a case in the flush switch.
                     // (Dispatched by opcode -- no JS import needed.) Its marker
                     // import still needs a no-op stub at instantiation time.
-                    gen_js_case(d, cases_w);
+                    gen_js_case(d, cases_w, case_opts);
+                    table_entries.push_back({d.opcode, d.ns + "_" + d.func_name});
+                    op_names[d.opcode] = d.ns + "." + d.func_name;
                     any_void_command_used = true;
+                    if (d.bind_slot >= 0)
+                        any_bound_command_used = true;
                 }
 
                 used_namespaces.insert(d.ns);
@@ -1003,6 +1665,12 @@ namespace webcc
             }
         }
 
+        if (options.stats)
+        {
+            generated_js_imports.push_back("webcc_stats_print: () => webcc_stats()");
+            generated_js_imports.push_back("webcc_stats_now_us: () => (performance.now() * 1000) >>> 0");
+        }
+
         w.raw(JS_INIT_HEAD);
         w.set_indent(3);
 
@@ -1032,7 +1700,9 @@ namespace webcc
         std::stringstream exports_ss;
         exports_ss << "const { ";
         exports_ss << "memory, main, __indirect_function_table: table";
-        exports_ss << ", webcc_event_buffer_ptr, webcc_event_offset_ptr, webcc_event_buffer_capacity, webcc_scratch_buffer_ptr";
+        exports_ss << ", webcc_event_buffer_ptr, webcc_event_offset_ptr, webcc_event_buffer_capacity, webcc_event_alloc, webcc_frame_end, webcc_heap_stats_ptr, webcc_scratch_buffer_ptr";
+        if (options.stats)
+            exports_ss << ", webcc_stats_ptr, webcc_stats_decoded";
         exports_ss << " } = mod.instance.exports;";
         w.write(exports_ss.str());
         w.write("");
@@ -1041,7 +1711,7 @@ namespace webcc
         w.write("const event_buffer_ptr_val = webcc_event_buffer_ptr();");
         w.write("const event_offset_ptr_val = webcc_event_offset_ptr();");
         w.write("const scratch_buffer_ptr_val = webcc_scratch_buffer_ptr();");
-        w.write("let event_offset_view = new Uint32Array(memory.buffer, event_offset_ptr_val, 1);");
+        w.write("let event_ring = new Uint32Array(memory.buffer, event_offset_ptr_val, 32); // EventRing");
         w.write("let event_u8 = new Uint8Array(memory.buffer, event_buffer_ptr_val);");
         w.write("let event_i32 = new Int32Array(memory.buffer, event_buffer_ptr_val);");
         w.write("let event_f32 = new Float32Array(memory.buffer, event_buffer_ptr_val);");
@@ -1066,12 +1736,14 @@ namespace webcc
         w.write("function _triggerDiscreteUpdate() {");
         w.write("    if (_updateFn && !_updatePending) {");
         w.write("        _updatePending = true;");
-        w.write("        queueMicrotask(() => { _updatePending = false; _updateFn(performance.now()); });");
+        w.write("        queueMicrotask(() => { _updatePending = false; _updateFn(performance.now()); _frameEnd(); });");
         w.write("    }");
         w.write("}");
+        w.raw(JS_HEAP);
         w.write("");
 
         // Generate push_event helpers in JS only for event types that are actually used.
+        std::vector<const SchemaEvent *> pushed_events;
         for (const auto &d : defs.events)
         {
             bool helper_needed = used_event_helpers.count(d.ns + "::" + d.name) > 0;
@@ -1080,9 +1752,24 @@ namespace webcc
             std::string event_lower = d.name;
             for (auto &c : event_lower) c = std::tolower(c);
 
-            if (!helper_needed && used_event_listeners.find(event_lower) == used_event_listeners.end())
-                continue;
-
+            if (helper_needed || used_event_listeners.count(event_lower))
+                pushed_events.push_back(&d);
+        }
+        if (!pushed_events.empty())
+            w.raw(JS_EVENT_RING);
+        // Where the last coalescing or batched event was queued, for the next
+        // one to fold into.
+        for (const SchemaEvent *d : pushed_events)
+        {
+            if (d->coalesce != Coalesce::None || d->batch)
+            {
+                w.raw(JS_EVENT_FOLD);
+                break;
+            }
+        }
+        for (const SchemaEvent *event : pushed_events)
+        {
+            const SchemaEvent &d = *event;
             std::stringstream sig;
             sig << "function push_event_" << d.ns << "_" << d.name << "(";
             for (size_t i = 0; i < d.params.size(); ++i)
@@ -1094,51 +1781,187 @@ namespace webcc
             sig << ") {";
             w.write(sig.str());
 
-            w.write("if (event_u8.buffer !== memory.buffer) {");
-            w.write("event_u8 = new Uint8Array(memory.buffer, event_buffer_ptr_val);");
-            w.write("event_i32 = new Int32Array(memory.buffer, event_buffer_ptr_val);");
-            w.write("event_f32 = new Float32Array(memory.buffer, event_buffer_ptr_val);");
-            w.write("event_f64 = new Float64Array(memory.buffer, event_buffer_ptr_val);");
-            w.write("event_offset_view = new Uint32Array(memory.buffer, event_offset_ptr_val, 1);");
-            w.write("}");
+            w.write("if (event_u8.buffer !== memory.buffer) event_views();");
+            // EventRing.muted (word 18 on): the app unsubscribed from this event.
+            w.write("if (event_ring[" + std::to_string(18 + (d.opcode >> 5)) + "] & (1 << " + std::to_string(d.opcode & 31) + ")) return;");
 
-            w.write("if (event_offset_view[0] + 4096 > EVENT_BUFFER_SIZE) { console.warn('WebCC: Event buffer full, dropping event " + d.name + "'); return; }");
-            w.write("let pos = event_offset_view[0];");
-            w.write("const start_pos = pos;");
-            w.write("event_u8[pos] = " + std::to_string((int)d.opcode) + ";");
-            w.write("pos += 4; // Skip header (opcode + pad + size)");
+            // Writes the fields after the header at `pos`; `op` is "=" or, when
+            // accumulating into a queued event, "+=".
+            auto write_fields = [&](const std::string &op)
+            {
+                for (size_t i = 0; i < d.params.size(); ++i)
+                {
+                    const auto &p = d.params[i];
+                    std::string name = p.name.empty() ? ("arg" + std::to_string(i)) : p.name;
+                    if (p.type == "int32" || p.type == "uint32" || p.type == "uint8" || p.type == "handle")
+                        w.write("event_i32[pos >> 2] " + op + " " + name + "; pos += 4;");
+                    else if (p.type == "float32")
+                        w.write("event_f32[pos >> 2] " + op + " " + name + "; pos += 4;");
+                    else if (p.type == "float64")
+                    {
+                        w.write("pos = (pos + 7) & ~7;"); // Align to 8 bytes
+                        w.write("event_f64[pos >> 3] " + op + " " + name + "; pos += 8;");
+                    }
+                    else if (p.type == "string")
+                    {
+                        std::string n = std::to_string(i);
+                        w.write("if (big_" + n + ") {");
+                        w.write("event_i32[pos >> 2] = len_" + n + " | 0x80000000; event_i32[(pos >> 2) + 1] = ptr_" + n + "; pos += 8;");
+                        w.write("new Uint8Array(memory.buffer, ptr_" + n + ", len_" + n + ").set(encoded_" + n + ");");
+                        w.write("} else {");
+                        w.write("event_i32[pos >> 2] = len_" + n + "; pos += 4;");
+                        w.write("new Uint8Array(memory.buffer, event_buffer_ptr_val + pos).set(encoded_" + n + ");");
+                        w.write("pos += (len_" + n + " + 3) & ~3;");
+                        w.write("}");
+                    }
+                }
+            };
+
+            const std::string opcode = std::to_string((int)d.opcode);
+            // The flags byte; with --stats, EVENT_STAMPED and the push time in
+            // microseconds after the header, for webcc::stats::event_latency().
+            const size_t stamp_bytes = options.stats ? 4 : 0;
+            const std::string header = std::to_string(4 + stamp_bytes);
+            // Records that later events fold into are published EVENT_OPEN.
+            const int open = d.coalesce != Coalesce::None || d.batch ? 2 : 0;
+            auto write_stamp = [&]()
+            {
+                if (stamp_bytes)
+                    w.write("event_u8[pos + 1] = " + std::to_string(1 | open) + "; event_i32[(pos + 4) >> 2] = (performance.now() * 1000) >>> 0;");
+                else
+                    w.write("event_u8[pos + 1] = " + std::to_string(open) + "; // flags");
+            };
+            if (d.batch)
+            {
+                // Append a sample to the block at the end of the ring while it
+                // is unread and not full, else start a new one. Column j of a
+                // block holds param j of every sample.
+                const std::string n = std::to_string(d.batch);
+                size_t block = 8 + stamp_bytes;
+                for (const auto &p : d.params)
+                    block += p.type == "float64" ? 8 * d.batch + 4 : 4 * d.batch;
+                w.write("let pos = -1, i = 0;");
+                w.write("if (event_claim(" + opcode + ")) {");
+                w.write("const at = event_last_pos & EVENT_RING_MASK;");
+                w.write("i = event_i32[(at + " + header + ") >> 2];");
+                w.write("if (i < " + n + ") { pos = at; event_i32[(at + " + header + ") >> 2] = i + 1; }");
+                w.write("else { event_claimed &= ~0x200; event_unclaim(); i = 0; } // full: close it");
+                w.write("}");
+                w.write("if (pos < 0) {");
+                w.write("pos = event_reserve(" + std::to_string(block) + ");");
+                if (release)
+                    w.write("if (pos < 0) return;");
+                else
+                    w.write("if (pos < 0) { console.warn('WebCC: Event buffer full, dropping event " + d.name + "'); return; }");
+                w.write("i = 0;");
+                w.write("event_u8[pos] = " + opcode + ";");
+                write_stamp();
+                w.write("event_i32[(pos + " + header + ") >> 2] = 1; // sample count");
+                w.write("}");
+                w.write("let col = pos + " + std::to_string(8 + stamp_bytes) + ";");
+                for (size_t i = 0; i < d.params.size(); ++i)
+                {
+                    const auto &p = d.params[i];
+                    std::string name = p.name.empty() ? ("arg" + std::to_string(i)) : p.name;
+                    if (p.type == "float64")
+                    {
+                        w.write("col = (col + 7) & ~7;");
+                        w.write("event_f64[(col >> 3) + i] = " + name + "; col += " + std::to_string(8 * d.batch) + ";");
+                    }
+                    else
+                        w.write(std::string(p.type == "float32" ? "event_f32" : "event_i32") + "[(col >> 2) + i] = " + name + "; col += " + std::to_string(4 * d.batch) + ";");
+                }
+                w.write("if (i === 0) {");
+                w.write("const len = col - pos;");
+                w.write("event_u8[pos + 2] = len & 0xFF;");
+                w.write("event_u8[pos + 3] = (len >> 8) & 0xFF;");
+                w.write("event_publish(len);");
+                w.write("event_last_pos = event_at; event_last_end = event_ring[0];");
+                w.write("} else {");
+                w.write("event_unclaim();");
+                w.write("}");
+                w.write("}");
+                continue;
+            }
 
+            // The most this event can take: header, fields, float64 alignment
+            // and the padded string bytes, which are only known once encoded.
+            size_t fixed = 4 + stamp_bytes;
+            std::string need;
+            std::string big; // how many strings go out of band
             for (size_t i = 0; i < d.params.size(); ++i)
             {
                 const auto &p = d.params[i];
-                std::string name = p.name.empty() ? ("arg" + std::to_string(i)) : p.name;
-                if (p.type == "int32")
-                    w.write("event_i32[pos >> 2] = " + name + "; pos += 4;");
-                else if (p.type == "uint32")
-                    w.write("event_i32[pos >> 2] = " + name + "; pos += 4;");
-                else if (p.type == "uint8")
-                    w.write("event_i32[pos >> 2] = " + name + "; pos += 4;");
-                else if (p.type == "handle")
-                    w.write("event_i32[pos >> 2] = " + name + "; pos += 4;");
-                else if (p.type == "float32")
-                    w.write("event_f32[pos >> 2] = " + name + "; pos += 4;");
-                else if (p.type == "float64") {
-                    w.write("pos = (pos + 7) & ~7;"); // Align to 8 bytes
-                    w.write("event_f64[pos >> 3] = " + name + "; pos += 8;");
-                }
+                if (p.type == "float64")
+                    fixed += 12;
                 else if (p.type == "string")
                 {
-                    w.write("const encoded_" + std::to_string(i) + " = text_encoder.encode(" + name + ");");
-                    w.write("const len_" + std::to_string(i) + " = encoded_" + std::to_string(i) + ".length;");
-                    w.write("event_i32[pos >> 2] = len_" + std::to_string(i) + "; pos += 4;");
-                    w.write("new Uint8Array(memory.buffer, event_buffer_ptr_val + pos).set(encoded_" + std::to_string(i) + ");");
-                    w.write("pos += (len_" + std::to_string(i) + " + 3) & ~3;");
+                    std::string name = p.name.empty() ? ("arg" + std::to_string(i)) : p.name;
+                    std::string n = std::to_string(i);
+                    w.write("const encoded_" + n + " = event_bytes(" + name + ");");
+                    w.write("const len_" + n + " = encoded_" + n + ".length;");
+                    // Longer ones go to the heap: [len][ptr] here plus the
+                    // pointer at the end of the record.
+                    w.write("const big_" + n + " = len_" + n + " > " + std::to_string(EVENT_INLINE_MAX) + ";");
+                    fixed += 4;
+                    need += " + (big_" + n + " ? 8 : ((len_" + n + " + 3) & ~3))";
+                    big += std::string(big.empty() ? "" : " + ") + "big_" + n;
                 }
+                else
+                    fixed += 4;
+            }
+
+            // A queued event of the same type that C++ has not read yet is
+            // still the last one in the ring: fold this one into it.
+            if (d.coalesce != Coalesce::None)
+            {
+                w.write("if (event_claim(" + opcode + ")) {");
+                w.write("let pos = (event_last_pos & EVENT_RING_MASK) + " + header + ";");
+                write_fields(d.coalesce == Coalesce::Accumulate ? "+=" : "=");
+                w.write("event_unclaim();");
+                w.write("return;");
+                w.write("}");
+            }
+
+            w.write("let pos = event_reserve(" + std::to_string(fixed) + need + ");");
+            if (release)
+                w.write("if (pos < 0) return;");
+            else
+                w.write("if (pos < 0) { console.warn('WebCC: Event buffer full, dropping event " + d.name + "'); return; }");
+            if (!big.empty())
+            {
+                // Allocating may grow the memory, which detaches the views.
+                for (size_t i = 0; i < d.params.size(); ++i)
+                {
+                    if (d.params[i].type != "string")
+                        continue;
+                    std::string n = std::to_string(i);
+                    w.write("const ptr_" + n + " = big_" + n + " ? webcc_event_alloc(len_" + n + ") : 0;");
+                    if (release)
+                        w.write("if (big_" + n + " && !ptr_" + n + ") return;");
+                    else
+                        w.write("if (big_" + n + " && !ptr_" + n + ") { console.warn('WebCC: Out of memory, dropping event " + d.name + "'); return; }");
+                }
+                w.write("if (event_u8.buffer !== memory.buffer) event_views();");
+            }
+            w.write("const start_pos = pos;");
+            w.write("event_u8[pos] = " + opcode + ";");
+            write_stamp();
+            w.write("pos += " + header + "; // Skip header (opcode + flags + size" + (stamp_bytes ? " + stamp" : "") + ")");
+            write_fields("=");
+            if (!big.empty())
+            {
+                for (size_t i = 0; i < d.params.size(); ++i)
+                    if (d.params[i].type == "string")
+                        w.write("if (big_" + std::to_string(i) + ") { event_i32[pos >> 2] = ptr_" + std::to_string(i) + "; pos += 4; }");
+                w.write("event_u8[start_pos + 1] |= (" + big + ") << 4;");
             }
             w.write("const len = pos - start_pos;");
             w.write("event_u8[start_pos + 2] = len & 0xFF;");
             w.write("event_u8[start_pos + 3] = (len >> 8) & 0xFF;");
-            w.write("event_offset_view[0] = pos;");
+            w.write("event_publish(len);");
+            if (d.coalesce != Coalesce::None)
+                w.write("event_last_pos = event_at; event_last_end = event_ring[0];");
             w.write("}");
         }
 
@@ -1154,6 +1977,10 @@ namespace webcc
             }
         }
 
+        // Decoded interned strings, indexed by id (filled by the INTERN built-in).
+        if (case_opts.interned_strings)
+            w.write("const interned_strings = [];");
+
         // Emit global event delegation listeners (more efficient than per-element listeners)
         if (used_event_listeners.count("click"))
         {
@@ -1218,8 +2045,170 @@ namespace webcc
             w.write("});");
         }
 
-        w.raw(JS_FLUSH_HEAD);
-        w.raw(cases_w.str());
+        // Compact format: the BIND built-in is needed once any used command
+        // takes its handle from a bind register.
+        const bool compact = defs.wire_version >= 2;
+        // Opens a built-in's case (or handler) and records it for the table.
+        auto open_builtin = [&](uint8_t op, const std::string &name)
+        {
+            cases_w.write(js_case_open(op, name, compact, case_opts));
+            table_entries.push_back({op, name});
+            op_names[op] = "webcc." + name;
+        };
+        auto close_builtin = [&]()
+        {
+            cases_w.write(js_case_close(case_opts));
+            cases_w.write("}");
+            if (case_opts.table_dispatch)
+                cases_w.write("");
+        };
+
+        if (any_bound_command_used)
+        {
+            open_builtin(OP_BIND, "bind");
+            cases_w.write(bounds_check(5, "bind"));
+            cases_w.write("bound[u8[pos]] = dv.getInt32(pos + 1, true); pos += 5;");
+            close_builtin();
+        }
+
+        if (case_opts.interned_strings)
+        {
+            open_builtin(OP_INTERN, "intern");
+            if (compact)
+            {
+                cases_w.write(bounds_check(8, "intern"));
+                cases_w.write("const id = dv.getUint32(pos, true);");
+                cases_w.write("const len = dv.getUint32(pos + 4, true); pos += 8;");
+                cases_w.write("interned_strings[id] = decoder.decode(u8.subarray(pos, pos + len)); pos += len;");
+            }
+            else
+            {
+                cases_w.write(bounds_check(8, "intern"));
+                cases_w.write("const id = i32[pos >> 2];");
+                cases_w.write("const len = i32[(pos + 4) >> 2]; pos += 8;");
+                cases_w.write("interned_strings[id] = decoder.decode(u8.subarray(pos, pos + len)); pos += (len + 3) & ~3;");
+            }
+            close_builtin();
+        }
+
+        if (display_lists_used)
+        {
+            const std::string op_size = compact ? "1" : "4";
+            const std::string read_id = compact ? "dv.getInt32(pos, true)" : "i32[pos >> 2]";
+            open_builtin(OP_BEGIN_RECORD, "begin_record");
+            cases_w.write(bounds_check(4, "begin_record"));
+            cases_w.write("rec_id = " + read_id + "; pos += 4;");
+            cases_w.write("rec_from = pos; rec_parts = [];");
+            close_builtin();
+            open_builtin(OP_END_RECORD, "end_record");
+            cases_w.write("if (rec_id < 0) " + js_case_close(case_opts));
+            cases_w.write("rec_chunk(rec_from, pos - " + op_size + ");");
+            cases_w.write("display_lists[rec_id] = rec_parts; rec_id = -1; rec_parts = null;");
+            close_builtin();
+            open_builtin(OP_REPLAY, "replay");
+            cases_w.write(bounds_check(4, "replay"));
+            cases_w.write("const parts = display_lists[" + read_id + "]; pos += 4;");
+            cases_w.write("if (parts) for (const part of parts) exec(...part);");
+            close_builtin();
+            open_builtin(OP_DISCARD_LIST, "discard_list");
+            cases_w.write(bounds_check(4, "discard"));
+            cases_w.write("display_lists[" + read_id + "] = undefined; pos += 4;");
+            close_builtin();
+        }
+
+        if (compact)
+        {
+            w.raw(JS_DECODE_VIEWS_COMPACT);
+            if (display_lists_used)
+                w.raw(JS_DISPLAY_LISTS_COMPACT);
+            w.raw(JS_FLUSH_HEAD_COMPACT);
+        }
+        else
+        {
+            w.raw(JS_DECODE_VIEWS);
+            if (display_lists_used)
+                w.raw(JS_DISPLAY_LISTS);
+            w.raw(JS_FLUSH_HEAD);
+        }
+        // A record left open at the end of a flush keeps the executed bytes
+        // and carries on from the start of the next one.
+        if (display_lists_used)
+            w.raw("        if (rec_id >= 0) rec_from = ptr;\n");
+        if (options.capture)
+            w.raw("        capture_flush(ptr, size);\n");
+        if (options.stats)
+            w.raw("        const t0 = performance.now();\n");
+        w.raw(compact ? "        exec(u8, dv, ptr, ptr + size);\n" : "        exec(u8, i32, f32, f64, ptr, ptr + size);\n");
+        if (display_lists_used)
+            w.raw("        if (rec_id >= 0) rec_chunk(rec_from, ptr + size);\n");
+        if (options.stats)
+            w.raw("        webcc_stats_decoded(performance.now() - t0);\n");
+
+        if (case_opts.table_dispatch)
+        {
+            if (compact)
+                w.raw(JS_EXEC_TABLE_COMPACT);
+            else
+                w.raw(release ? JS_EXEC_TABLE_RELEASE : JS_EXEC_TABLE);
+            w.set_indent(1);
+
+            // Last-handle caches for the maps the handlers read through
+            // <map>_at() (see write_js_action).
+            for (const auto &map : JS_CACHED_MAPS)
+            {
+                if (!used_maps.count(map))
+                    continue;
+                w.write("let " + map + "_h = -1, " + map + "_v;");
+                // A missing entry is not cached, so a handle created later
+                // (e.g. asynchronously) is still found.
+                w.write("function " + map + "_at(h) {");
+                w.write("if (h === " + map + "_h) return " + map + "_v;");
+                w.write("const v = " + map + "[h];");
+                w.write("if (v !== undefined) { " + map + "_h = h; " + map + "_v = v; }");
+                w.write("return v;");
+                w.write("}");
+            }
+            w.write("");
+            w.raw(cases_w.str());
+
+            std::string sig = compact ? "(u8, dv, pos, end)" : "(u8, i32, f32, f64, pos, end)";
+            w.write("function op_unknown" + sig + " {");
+            if (!release)
+                w.write(std::string("console.error(\"Unknown opcode:\", ") + (compact ? "u8[pos - 1]" : "i32[(pos - 4) >> 2]") + ");");
+            w.write("return end;");
+            w.write("}");
+            w.write("");
+            w.write("// Dense dispatch table: one handler per opcode.");
+            w.write("const ops = new Array(256).fill(op_unknown);");
+            std::sort(table_entries.begin(), table_entries.end());
+            for (const auto &e : table_entries)
+                w.write("ops[" + std::to_string(e.first) + "] = op_" + e.second + ";");
+        }
+        else
+        {
+            if (compact)
+                w.raw(JS_EXEC_HEAD_COMPACT);
+            else
+                w.raw(release ? JS_EXEC_HEAD_RELEASE : JS_EXEC_HEAD);
+            w.raw(cases_w.str());
+            w.raw(release ? JS_EXEC_DEFAULT_RELEASE : JS_EXEC_DEFAULT);
+            w.raw(JS_EXEC_CLOSE);
+        }
+        if (options.stats)
+        {
+            w.write("");
+            w.write("const stats_op_names = {");
+            for (const auto &e : op_names)
+                w.write("    " + std::to_string(e.first) + ": \"" + e.second + "\",");
+            w.write("};");
+            w.raw(JS_STATS);
+        }
+        if (options.capture)
+        {
+            w.write("");
+            w.write("const capture_wire = " + std::to_string(defs.wire_version) + ";");
+            w.raw(JS_CAPTURE);
+        }
         w.raw(JS_TAIL);
         write_file(out_dir + "/app.js", w.str());
         std::cout << "[WebCC] Generated " << out_dir << "/app.js" << std::endl;
@@ -1297,7 +2286,7 @@ namespace webcc
         std::cout << "[WebCC] Generated " << out_dir << "/index.html" << std::endl;
     }
 
-    bool compile_wasm(const std::vector<std::string> &input_files, const std::string &out_dir, const std::string &cache_dir, const std::set<std::string> &required_exports)
+    bool compile_wasm(const std::vector<std::string> &input_files, const std::string &out_dir, const std::string &cache_dir, const std::set<std::string> &required_exports, const CompileOptions &options)
     {
         // Check Clang version (requires 16+ for full C++20 support)
         FILE *pipe = popen("clang++ --version 2>&1", "r");
@@ -1360,7 +2349,10 @@ namespace webcc
         all_sources.push_back(exe_dir + "/src/core/command_buffer.cc");
         all_sources.push_back(exe_dir + "/src/core/event_buffer.cc");
         all_sources.push_back(exe_dir + "/src/core/scratch_buffer.cc");
+        all_sources.push_back(exe_dir + "/src/core/frame_arena.cc");
+        all_sources.push_back(exe_dir + "/src/core/heap_stats.cc");
         all_sources.push_back(exe_dir + "/src/core/libc.cc");
+        all_sources.push_back(exe_dir + "/src/core/stats.cc");
 
         // --- 1. CONFIGURATION ---
         // base_cmd: Shared core settings for both compilation and linking.
@@ -1384,6 +2376,19 @@ namespace webcc
                                          "-ffunction-sections " // For better dead code elimination
                                          "-fdata-sections "     // For better dead code elimination
                                          "-c ";
+        // Instrumented objects are cached apart from normal ones.
+        std::string obj_suffix = ".o";
+        if (options.stats)
+        {
+            compile_only_flags += "-DWEBCC_STATS ";
+            obj_suffix = ".stats.o";
+        }
+        // SIMD128 (vectorised strlen/memchr in libc.cc, and auto-vectorised
+        // loops) is on unless --no-simd asks for the scalar fallback.
+        if (options.simd)
+            base_cmd += "-msimd128 ";
+        else
+            obj_suffix = ".nosimd" + obj_suffix;
 
         // link_only_flags: Build dynamically from required_exports with MEMORY OPTIMIZATIONS
         std::string link_only_flags = "-Wl,--no-entry ";
@@ -1393,6 +2398,8 @@ namespace webcc
         {
             link_only_flags += "-Wl,--export=" + exp + " ";
         }
+        if (options.stats)
+            link_only_flags += "-Wl,--export=webcc_stats_ptr -Wl,--export=webcc_stats_decoded ";
 
         // === CRITICAL MEMORY OPTIMIZATIONS FOR FAST MOUNT ===
         link_only_flags +=
@@ -1437,7 +2444,7 @@ namespace webcc
             for (char &c : obj_name)
                 if (!isalnum(c))
                     c = '_';
-            std::string obj = cache_dir + "/" + obj_name + ".o";
+            std::string obj = cache_dir + "/" + obj_name + obj_suffix;
 
             struct stat src_stat, obj_stat;
             bool need_compile = true;
@@ -11,12 +11,46 @@ namespace webcc
     // Independent of feature usage, so the wasm can be linked before detection.
     const std::set<std::string> &required_wasm_exports();
 
+    // Worst-case bytes a void command takes in the command buffer, not counting
+    // the padded payload of its string params. The generated wrapper reserves
+    // this much (plus the strings) with a single capacity check.
+    size_t encoded_size(const SchemaCommand &c);
+
     // Generates the C++ header files for each namespace (e.g., webcc/dom.h).
     // Also saves a binary schema cache for fast runtime loading.
     void emit_headers(const SchemaDefs &defs);
 
+    // Program-wide choices that change how command cases are decoded.
+    struct JsCaseOptions
+    {
+        bool interned_strings = false; // string params may carry an interned id (intern.h)
+        bool release = false;          // one bounds check per segment, no diagnostics (--release)
+        bool table_dispatch = false;   // emit op_<name> handlers instead of switch cases (--dispatch=table)
+    };
+
+    // How exec() in app.js finds the code for an opcode.
+    enum class JsDispatch
+    {
+        Switch, // one `switch (opcode)` over every used command (default)
+        Table,  // a dense array of small per-opcode handler functions
+    };
+
+    // Build-wide choices for generate_js_runtime, from the command line.
+    struct JsRuntimeOptions
+    {
+        bool release = false; // --release: lean decoder, no diagnostics
+        JsDispatch dispatch = JsDispatch::Switch;
+        bool stats = false;   // --stats: time the decode loop, add webcc_stats()
+        bool capture = false; // --capture: record flushes and calls (disasm.h)
+    };
+
     // Generates the JavaScript 'case' block for a single command's opcode.
-    void gen_js_case(const SchemaCommand &c, class CodeWriter &w);
+    void gen_js_case(const SchemaCommand &c, class CodeWriter &w, const JsCaseOptions &opts = {});
+
+    // Removes console.warn/console.error calls whose first argument is a string
+    // literal, i.e. the runtime's own diagnostics. Calls that log a value (the
+    // user's system::warn/error) are kept.
+    std::string strip_js_diagnostics(const std::string &js);
 
     // Scans a JS action string to find which resource maps it uses.
     std::set<std::string> get_maps_from_action(const std::string &action);
@@ -35,7 +69,12 @@ namespace webcc
     // import names from module "wjs_fn", each of the form `name(params){body}`
     // (the JS source itself). Every entry is mirrored back into app.js as a
     // matching handler. See js.h.
-    void generate_js_runtime(const SchemaDefs &defs, const std::set<std::string> &wasm_imports, const std::set<std::string> &void_markers, const std::set<std::string> &inline_js_fns, const std::string &out_dir);
+    //
+    // `options.release` (--release) generates the lean decoder: bounds checks
+    // merged per command, and the runtime's diagnostic messages stripped.
+    // `options.dispatch` (--dispatch=table) replaces the opcode switch with a
+    // table of per-opcode handlers that cache the last context/element lookup.
+    void generate_js_runtime(const SchemaDefs &defs, const std::set<std::string> &wasm_imports, const std::set<std::string> &void_markers, const std::set<std::string> &inline_js_fns, const std::string &out_dir, const JsRuntimeOptions &options = {});
 
     // Generates the HTML scaffolding (index.html).
     // If a template file exists (index.template.html), uses it and injects the script tag.
@@ -43,8 +82,15 @@ namespace webcc
     // If no placeholder, script is injected before </body>.
     void generate_html(const std::string &out_dir, const std::string &template_path = "");
 
+    // Build switches that change the compiled code (and so the object cache).
+    struct CompileOptions
+    {
+        bool stats = false; // --stats: define WEBCC_STATS (see webcc/core/stats.h)
+        bool simd = true;   // --no-simd: build without -msimd128 (scalar strlen/memchr)
+    };
+
     // Compiles the C++ code to WebAssembly.
     // required_exports: set of function names that JS needs exported from WASM
-    bool compile_wasm(const std::vector<std::string> &input_files, const std::string &out_dir, const std::string &cache_dir, const std::set<std::string> &required_exports);
+    bool compile_wasm(const std::vector<std::string> &input_files, const std::string &out_dir, const std::string &cache_dir, const std::set<std::string> &required_exports, const CompileOptions &options = {});
 
 } // namespace webcc
@@ -53,15 +53,30 @@ const run = async () => {
     }
 )";
 
-    // JS code for the 'flush' function, which processes commands from C++.
-    const std::string JS_FLUSH_HEAD = R"(
+    // Views over wasm memory used by the command decoder.
+    const std::string JS_DECODE_VIEWS = R"(
     // Reusable text decoder to avoid garbage collection overhead
     const decoder = new TextDecoder();
     let u8 = new Uint8Array(memory.buffer);
     let i32 = new Int32Array(memory.buffer);
     let f32 = new Float32Array(memory.buffer);
     let f64 = new Float64Array(memory.buffer);
+)";
+
+    // Compact (v2) wire format: byte opcodes and unaligned values, read
+    // through a DataView. `bound` holds the bind registers (see OP_BIND in
+    // command_buffer.h).
+    const std::string JS_DECODE_VIEWS_COMPACT = R"(
+    // Reusable text decoder to avoid garbage collection overhead
+    const decoder = new TextDecoder();
+    let u8 = new Uint8Array(memory.buffer);
+    let dv = new DataView(memory.buffer);
+    const bound = [];
+)";
 
+    // Opens 'flush', which C++ calls with the commands it buffered. The
+    // generator closes it after the call into exec().
+    const std::string JS_FLUSH_HEAD = R"(
     function flush(ptr, size) {
         if (size === 0) return;
 
@@ -72,9 +87,24 @@ const run = async () => {
             f64 = new Float64Array(memory.buffer);
         }
 
-        let pos = ptr;
-        const end = ptr + size;
+)";
+
+    const std::string JS_FLUSH_HEAD_COMPACT = R"(
+    function flush(ptr, size) {
+        if (size === 0) return;
 
+        if (u8.buffer !== memory.buffer) {
+            u8 = new Uint8Array(memory.buffer);
+            dv = new DataView(memory.buffer);
+        }
+
+)";
+
+    // 'exec' decodes and runs the commands in [pos, end) of the views it is
+    // given: wasm memory for a flush, or a display list's copy for a replay.
+    const std::string JS_EXEC_HEAD = R"(    }
+
+    function exec(u8, i32, f32, f64, pos, end) {
         // Loop through the buffer
         while (pos < end) {
             if (pos + 4 > end) {
@@ -87,15 +117,304 @@ const run = async () => {
             switch (opcode) {
 )";
 
-    // The constant "footer" for the generated JS file.
-    const std::string JS_TAIL = R"(
+    // Release builds (--release) drop the opcode check: the C++ side only
+    // commits whole commands, and v1 offsets are 4-aligned, so an opcode never
+    // straddles `end`.
+    const std::string JS_EXEC_HEAD_RELEASE = R"(    }
+
+    function exec(u8, i32, f32, f64, pos, end) {
+        while (pos < end) {
+            const opcode = i32[pos >> 2];
+            pos += 4;
+
+            switch (opcode) {
+)";
+
+    const std::string JS_EXEC_HEAD_COMPACT = R"(    }
+
+    function exec(u8, dv, pos, end) {
+        // Loop through the buffer
+        while (pos < end) {
+            const opcode = u8[pos];
+            pos += 1;
+
+            switch (opcode) {
+)";
+
+    // Retained display lists (display_list.h), indexed by id. A list is an
+    // array of parts, one per flush the record spanned; each part holds the
+    // arguments exec() needs to run it. rec_chunk() copies from an 8-aligned
+    // address so the f64 reads in a part stay aligned.
+    const std::string JS_DISPLAY_LISTS = R"(
+    const display_lists = [];
+    let rec_id = -1, rec_from = 0, rec_parts = null;
+    function rec_chunk(from, to) {
+        if (to <= from) return;
+        const base = from & ~7;
+        const bytes = new Uint8Array((to - base + 7) & ~7);
+        bytes.set(u8.subarray(base, to));
+        const buf = bytes.buffer;
+        rec_parts.push([bytes, new Int32Array(buf), new Float32Array(buf), new Float64Array(buf), from - base, to - base]);
+    }
+)";
+
+    const std::string JS_DISPLAY_LISTS_COMPACT = R"(
+    const display_lists = [];
+    let rec_id = -1, rec_from = 0, rec_parts = null;
+    function rec_chunk(from, to) {
+        if (to <= from) return;
+        const bytes = u8.slice(from, to);
+        rec_parts.push([bytes, new DataView(bytes.buffer), 0, to - from]);
+    }
+)";
+
+    // Closes the switch in exec(). Release builds stop on an unknown opcode
+    // without logging it.
+    const std::string JS_EXEC_DEFAULT = R"(
                 default:
                     console.error("Unknown opcode:", opcode);
-                    return;
+                    return;)";
+
+    const std::string JS_EXEC_DEFAULT_RELEASE = R"(
+                default:
+                    return;)";
+
+    // Closes the switch, the loop and exec().
+    const std::string JS_EXEC_CLOSE = R"(
+            }
+        }
+    }
+)";
+
+    // exec() for --dispatch=table: each opcode has its own small handler,
+    // op_<ns>_<func>, which decodes its fields, runs the action and returns
+    // the offset of the next command. The handlers and the `ops` table follow.
+    const std::string JS_EXEC_TABLE = R"(    }
+
+    function exec(u8, i32, f32, f64, pos, end) {
+        while (pos < end) {
+            if (pos + 4 > end) {
+                console.error("WebCC: Unexpected end of buffer reading opcode");
+                break;
             }
+            pos = ops[i32[pos >> 2]](u8, i32, f32, f64, pos + 4, end);
         }
     }
 
+)";
+
+    const std::string JS_EXEC_TABLE_RELEASE = R"(    }
+
+    function exec(u8, i32, f32, f64, pos, end) {
+        while (pos < end) pos = ops[i32[pos >> 2]](u8, i32, f32, f64, pos + 4, end);
+    }
+
+)";
+
+    const std::string JS_EXEC_TABLE_COMPACT = R"(    }
+
+    function exec(u8, dv, pos, end) {
+        while (pos < end) pos = ops[u8[pos]](u8, dv, pos + 1, end);
+    }
+
+)";
+
+    // Console report for the instrumented build (webcc --stats), also reached
+    // from webcc::stats::print(). Reads webcc::stats::Totals straight out of
+    // wasm memory; the offsets are pinned in src/core/stats.cc.
+    // `stats_op_names` (opcode -> "ns.command") is emitted just before this.
+    const std::string JS_STATS = R"(
+    function webcc_stats() {
+        const dv = new DataView(memory.buffer, webcc_stats_ptr());
+        const u64 = (off) => dv.getUint32(off, true) + dv.getUint32(off + 4, true) * 4294967296;
+        const by_command = [], by_namespace = {};
+        for (let op = 0; op < 256; op++) {
+            const commands = u64(op * 16);
+            if (commands === 0) continue;
+            const bytes = u64(op * 16 + 8);
+            const name = stats_op_names[op] || ('op.' + op);
+            by_command.push({ command: name, opcode: op, commands, bytes, 'bytes/cmd': +(bytes / commands).toFixed(1) });
+            const ns = name.slice(0, name.indexOf('.'));
+            const row = by_namespace[ns] || (by_namespace[ns] = { commands: 0, bytes: 0 });
+            row.commands += commands;
+            row.bytes += bytes;
+        }
+        by_command.sort((a, b) => b.bytes - a.bytes);
+        const by_reason = {};
+        let flushes = 0;
+        ['explicit', 'overflow', 'getter', 'webcc_js'].forEach((reason, i) => {
+            const flushed = dv.getUint32(4144 + 4 * i, true);
+            by_reason[reason] = { requested: dv.getUint32(4128 + 4 * i, true), flushed };
+            flushes += flushed;
+        });
+        const decode_ms = dv.getFloat64(4112, true);
+        console.log(`WebCC: ${u64(4096)} commands, ${u64(4104)} bytes in ${flushes} flushes; ` +
+            `decode ${decode_ms.toFixed(2)} ms total, ${(flushes ? decode_ms / flushes : 0).toFixed(3)} ms avg, ` +
+            `${dv.getFloat64(4120, true).toFixed(3)} ms max`);
+        console.table(by_namespace);
+        console.table(by_command);
+        console.table(by_reason);
+    }
+    globalThis.webcc_stats = webcc_stats;
+)";
+
+    // End of a main-loop frame or discrete update (webcc_frame_end in
+    // src/core/frame_arena.cc), and the heap counters for the console.
+    // webcc::HeapStats is read at the offsets pinned in src/core/heap_stats.cc.
+    const std::string JS_HEAP = R"(
+    function _frameEnd() {
+        const allocs = webcc_frame_end();
+        if (allocs) console.warn(`WebCC: ${allocs} heap allocations in one frame, over the budget`);
+    }
+    function webcc_heap() {
+        const dv = new DataView(memory.buffer, webcc_heap_stats_ptr());
+        const u32 = (off) => dv.getUint32(off, true);
+        const u64 = (off) => u32(off) + u32(off + 4) * 4294967296;
+        const size_classes = {};
+        for (let k = 0; k < 26; k++) {
+            const n = u32(64 + 4 * k);
+            if (n) size_classes[k ? `${2 ** (k + 6)}-${2 ** (k + 7) - 1}` : '<128'] = n;
+        }
+        return {
+            allocs: u64(0), frees: u64(8), live_bytes: u32(16), peak_live_bytes: u32(20),
+            free_blocks: u32(24), free_bytes: u32(28), largest_free: u32(32),
+            heap_bytes: u32(36), committed_bytes: u32(40), grows: u32(44), grown_bytes: u32(48),
+            frame_allocs: u32(52), frame_alloc_budget: u32(56), frames_over_budget: u32(60),
+            size_classes,
+        };
+    }
+    globalThis.webcc_heap = webcc_heap;
+)";
+
+    // Producer side of the event ring (src/core/event_buffer.h). `event_ring`
+    // views EventRing as u32s: [0] head, [1] high_water, [2] dropped,
+    // [16] tail, [17] read. A push_event_* helper reserves its worst-case size,
+    // writes the record at the offset it gets and publishes its real length.
+    const std::string JS_EVENT_RING = R"(
+    const EVENT_RING_MASK = EVENT_BUFFER_SIZE - 1;
+    let event_at = 0; // ring counter where the record being written starts
+    function event_views() {
+        event_u8 = new Uint8Array(memory.buffer, event_buffer_ptr_val);
+        event_i32 = new Int32Array(memory.buffer, event_buffer_ptr_val);
+        event_f32 = new Float32Array(memory.buffer, event_buffer_ptr_val);
+        event_f64 = new Float64Array(memory.buffer, event_buffer_ptr_val);
+        event_ring = new Uint32Array(memory.buffer, event_offset_ptr_val, 32);
+    }
+    // Offset to write a record of at most `need` bytes at, or -1 if the ring is full.
+    function event_reserve(need) {
+        const head = event_ring[0];
+        const used = (head - Atomics.load(event_ring, 16)) >>> 0;
+        let pos = head & EVENT_RING_MASK;
+        const skip = pos + need > EVENT_BUFFER_SIZE ? EVENT_BUFFER_SIZE - pos : 0;
+        if (used + skip + need > EVENT_BUFFER_SIZE) { event_ring[2]++; return -1; }
+        if (skip) { event_u8[pos] = 0; pos = 0; } // skip marker: continue at the start
+        event_at = (head + skip) >>> 0;
+        return pos;
+    }
+    // A string param's bytes: text as UTF-8, binary data as is.
+    function event_bytes(v) {
+        if (v instanceof ArrayBuffer) return new Uint8Array(v);
+        if (ArrayBuffer.isView(v)) return new Uint8Array(v.buffer, v.byteOffset, v.byteLength);
+        return text_encoder.encode(v);
+    }
+    function event_publish(len) {
+        const head = (event_at + len) >>> 0;
+        const used = (head - Atomics.load(event_ring, 16)) >>> 0;
+        if (used > event_ring[1]) event_ring[1] = used;
+        Atomics.store(event_ring, 0, head);
+    }
+)";
+
+    // Folding into the record published last, for coalescing and batched
+    // events (emitted after JS_EVENT_RING when one is in use). The record
+    // must still be open (EVENT_OPEN, 0x200 in its header word; next_event()
+    // clears it before reading) and of the same type. event_claim() marks it
+    // EVENT_BUSY (0x400) with a compare-exchange, so a consumer on another
+    // thread never reads it half-updated; event_unclaim() hands it back.
+    const std::string JS_EVENT_FOLD = R"(
+    let event_last_pos = -1, event_last_end = -1, event_claimed = 0;
+    function event_claim(op) {
+        if (event_ring[0] !== event_last_end) return false;
+        const at = (event_last_pos & EVENT_RING_MASK) >> 2;
+        const h = Atomics.load(event_i32, at);
+        if ((h & 0x6FF) !== (0x200 | op) || Atomics.compareExchange(event_i32, at, h, h | 0x400) !== h) return false;
+        event_claimed = h;
+        return true;
+    }
+    function event_unclaim() {
+        Atomics.store(event_i32, (event_last_pos & EVENT_RING_MASK) >> 2, event_claimed);
+    }
+)";
+
+    // Command-stream capture (webcc --capture): every flush and every
+    // return-value call, tagged with the animation frame it happened in.
+    // webcc_capture() returns the capture in the format `webcc disasm` reads
+    // (src/cli/disasm.h); webcc_capture_download() saves it to a file.
+    // `capture_wire` is emitted just before this.
+    const std::string JS_CAPTURE = R"(
+    const capture_records = [];
+    let capture_frame = 0;
+    const capture_tick = () => { capture_frame++; requestAnimationFrame(capture_tick); };
+    requestAnimationFrame(capture_tick);
+    function capture_flush(ptr, size) {
+        capture_records.push({ kind: 1, frame: capture_frame, ptr, bytes: new Uint8Array(memory.buffer).slice(ptr, ptr + size) });
+    }
+    // `strings` lists the args that are string pointers; the length follows each.
+    function capture_call(name, args, strings) {
+        const m = new Uint8Array(memory.buffer);
+        const spans = strings.map((i) => ({ ptr: args[i], bytes: m.slice(args[i], args[i] + args[i + 1]) }));
+        capture_records.push({ kind: 2, frame: capture_frame, name: text_encoder.encode(name), args, spans });
+    }
+    function webcc_capture() {
+        const pad = (n) => (n + 3) & ~3;
+        let size = 16;
+        for (const r of capture_records) {
+            size += 8;
+            if (r.kind === 1) {
+                size += 8 + pad(r.bytes.length);
+            } else {
+                size += 4 + pad(r.name.length) + 4 + 8 * r.args.length + 4;
+                for (const s of r.spans) size += 8 + pad(s.bytes.length);
+            }
+        }
+        const out = new Uint8Array(size);
+        const dv = new DataView(out.buffer);
+        let pos = 0;
+        const u32 = (v) => { dv.setUint32(pos, v, true); pos += 4; };
+        const bytes = (b) => { out.set(b, pos); pos += pad(b.length); };
+        bytes(text_encoder.encode('WCCP'));
+        u32(1);
+        u32(capture_wire);
+        u32(0);
+        for (const r of capture_records) {
+            out[pos] = r.kind; pos += 4;
+            u32(r.frame);
+            if (r.kind === 1) {
+                u32(r.ptr); u32(r.bytes.length); bytes(r.bytes);
+                continue;
+            }
+            u32(r.name.length); bytes(r.name);
+            u32(r.args.length);
+            for (const a of r.args) { dv.setFloat64(pos, a, true); pos += 8; }
+            u32(r.spans.length);
+            for (const s of r.spans) { u32(s.ptr); u32(s.bytes.length); bytes(s.bytes); }
+        }
+        return out.buffer;
+    }
+    function webcc_capture_download(name = 'webcc.wccp') {
+        const url = URL.createObjectURL(new Blob([webcc_capture()]));
+        const a = document.createElement('a');
+        a.href = url;
+        a.download = name;
+        a.click();
+        setTimeout(() => URL.revokeObjectURL(url), 0);
+    }
+    globalThis.webcc_capture = webcc_capture;
+    globalThis.webcc_capture_download = webcc_capture_download;
+)";
+
+    // The constant "footer" for the generated JS file.
+    const std::string JS_TAIL = R"(
     // Run the C++ main function
     if (main) main();
 };
@@ -3,6 +3,7 @@
 #include "js_templates.h"
 #include "generators.h"
 #include "wasm.h"
+#include "disasm.h"
 #include <iostream>
 #include <sstream>
 #include <cstdlib>
@@ -19,6 +20,18 @@ int main(int argc, char **argv)
     std::string out_dir = ".";
     std::string cache_dir_arg = "";
     std::string template_path = "";
+    // --release generates the lean JS decoder; --debug (the default) keeps
+    // per-field bounds checks and diagnostic messages.
+    webcc::JsRuntimeOptions js_options;
+    // --stats builds the instrumented runtime (webcc/core/stats.h);
+    // --no-simd builds without wasm SIMD128.
+    webcc::CompileOptions compile_options;
+
+    // `webcc disasm ...` decodes a command-stream capture (see disasm.h).
+    if (argc > 1 && std::string(argv[1]) == "disasm")
+    {
+        return webcc::run_disasm(argc - 2, argv + 2);
+    }
 
     // Parse command-line arguments.
     for (int i = 1; i < argc; ++i)
@@ -53,6 +66,31 @@ int main(int argc, char **argv)
                 template_path = argv[++i];
             }
         }
+        else if (arg == "--release")
+        {
+            js_options.release = true;
+        }
+        else if (arg == "--debug")
+        {
+            js_options.release = false;
+        }
+        else if (arg == "--dispatch=table" || arg == "--dispatch=switch")
+        {
+            js_options.dispatch = arg == "--dispatch=table" ? webcc::JsDispatch::Table : webcc::JsDispatch::Switch;
+        }
+        else if (arg == "--stats")
+        {
+            compile_options.stats = true;
+            js_options.stats = true;
+        }
+        else if (arg == "--no-simd")
+        {
+            compile_options.simd = false;
+        }
+        else if (arg == "--capture")
+        {
+            js_options.capture = true;
+        }
         else
         {
             input_files.push_back(arg);
@@ -78,7 +116,7 @@ int main(int argc, char **argv)
 
     if (input_files.empty())
     {
-        std::cerr << "Usage: webcc [--defs <path>] [--out <dir> | -o <dir>] [--cache-dir <dir>] <source.cc> ... or webcc headers" << std::endl;
+        std::cerr << "Usage: webcc [--defs <path>] [--out <dir> | -o <dir>] [--cache-dir <dir>] [--release | --debug] [--dispatch=switch|table] [--stats] [--capture] [--no-simd] <source.cc> ... or webcc headers or webcc disasm <capture.wccp>" << std::endl;
         return 1;
     }
 
@@ -108,7 +146,7 @@ int main(int argc, char **argv)
     // Link first, with a constant set of exports, so the linked module's import
     // table becomes the ground-truth list of commands the user's code references
     // (the compiler/linker resolves those names; we never guess them).
-    if (!webcc::compile_wasm(input_files, out_dir, cache_dir, webcc::required_wasm_exports()))
+    if (!webcc::compile_wasm(input_files, out_dir, cache_dir, webcc::required_wasm_exports(), compile_options))
     {
         return 1;
     }
@@ -137,7 +175,7 @@ int main(int argc, char **argv)
     }
 
     // C. GENERATE JS RUNTIME (both command kinds detected from the import table).
-    webcc::generate_js_runtime(defs, wasm_imports, void_markers, inline_js_fns, out_dir);
+    webcc::generate_js_runtime(defs, wasm_imports, void_markers, inline_js_fns, out_dir, js_options);
 
     // E. GENERATE HTML (Basic scaffolding).
     webcc::generate_html(out_dir, template_path);
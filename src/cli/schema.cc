@@ -1,5 +1,6 @@
 #include "schema.h"
 #include "utils.h"
+#include "command_buffer.h"
 #include <iostream>
 #include <sstream>
 #include <cstdlib>
@@ -12,7 +13,7 @@ namespace webcc
 {
     // Binary cache magic and version for validation
     static constexpr uint32_t SCHEMA_MAGIC = 0x57434353; // "WCCS" (WebCC Schema)
-    static constexpr uint32_t SCHEMA_VERSION = 1;
+    static constexpr uint32_t SCHEMA_VERSION = 4;
 
     // Helper functions for binary serialization
     static void write_string(std::ostream &out, const std::string &s)
@@ -69,6 +70,22 @@ namespace webcc
             write_string(out, kv.second);
         }
 
+        // Wire options
+        out.write(reinterpret_cast<const char *>(&defs.wire_version), sizeof(defs.wire_version));
+        uint32_t precision_count = static_cast<uint32_t>(defs.precision.size());
+        out.write(reinterpret_cast<const char *>(&precision_count), sizeof(precision_count));
+        for (const auto &kv : defs.precision)
+        {
+            write_string(out, kv.first);
+            write_string(out, kv.second);
+        }
+        uint32_t bound_count = static_cast<uint32_t>(defs.bound_types.size());
+        out.write(reinterpret_cast<const char *>(&bound_count), sizeof(bound_count));
+        for (const auto &t : defs.bound_types)
+        {
+            write_string(out, t);
+        }
+
         // Commands
         uint32_t cmd_count = static_cast<uint32_t>(defs.commands.size());
         out.write(reinterpret_cast<const char *>(&cmd_count), sizeof(cmd_count));
@@ -98,6 +115,8 @@ namespace webcc
             write_string(out, e.ns);
             write_string(out, e.name);
             out.write(reinterpret_cast<const char *>(&e.opcode), sizeof(e.opcode));
+            out.write(reinterpret_cast<const char *>(&e.coalesce), sizeof(e.coalesce));
+            out.write(reinterpret_cast<const char *>(&e.batch), sizeof(e.batch));
 
             uint32_t param_count = static_cast<uint32_t>(e.params.size());
             out.write(reinterpret_cast<const char *>(&param_count), sizeof(param_count));
@@ -145,6 +164,22 @@ namespace webcc
             defs.handle_inheritance[key] = value;
         }
 
+        // Wire options
+        in.read(reinterpret_cast<char *>(&defs.wire_version), sizeof(defs.wire_version));
+        uint32_t precision_count;
+        in.read(reinterpret_cast<char *>(&precision_count), sizeof(precision_count));
+        for (uint32_t i = 0; i < precision_count && in; ++i)
+        {
+            std::string key = read_string(in);
+            defs.precision[key] = read_string(in);
+        }
+        uint32_t bound_count;
+        in.read(reinterpret_cast<char *>(&bound_count), sizeof(bound_count));
+        for (uint32_t i = 0; i < bound_count && in; ++i)
+        {
+            defs.bound_types.push_back(read_string(in));
+        }
+
         // Commands
         uint32_t cmd_count;
         in.read(reinterpret_cast<char *>(&cmd_count), sizeof(cmd_count));
@@ -180,6 +215,8 @@ namespace webcc
             e.ns = read_string(in);
             e.name = read_string(in);
             in.read(reinterpret_cast<char *>(&e.opcode), sizeof(e.opcode));
+            in.read(reinterpret_cast<char *>(&e.coalesce), sizeof(e.coalesce));
+            in.read(reinterpret_cast<char *>(&e.batch), sizeof(e.batch));
 
             uint32_t param_count;
             in.read(reinterpret_cast<char *>(&param_count), sizeof(param_count));
@@ -197,6 +234,7 @@ namespace webcc
             defs = SchemaDefs();
             return false;
         }
+        resolve_wire(defs);
 
         std::cout << "[WebCC] Loaded from binary cache: " << defs.commands.size() << " commands, " << defs.events.size() << " events" << std::endl;
         return true;
@@ -237,7 +275,7 @@ namespace webcc
         }
         std::istringstream ss(contents);
         std::string line;
-        uint8_t current_cmd_opcode = 1;
+        int current_cmd_opcode = 1;
         uint8_t current_event_opcode = 1;
         int line_num = 0;
         
@@ -273,6 +311,33 @@ namespace webcc
                 start = pos + 1;
             }
 
+            if (parts[0] == "meta") {
+                if (parts.size() >= 4 && parts[1] == "inherit") {
+                    // meta|inherit|Derived|Base
+                    out.handle_inheritance[parts[2]] = parts[3];
+                } else if (parts.size() >= 3 && parts[1] == "wire") {
+                    // meta|wire|compact
+                    if (parts[2] != "compact") {
+                        std::cerr << "[WebCC] Error: Unknown wire format '" << parts[2] << "' at line " << line_num << std::endl;
+                        exit(1);
+                    }
+                    out.wire_version = 2;
+                } else if (parts.size() >= 4 && parts[1] == "precision") {
+                    // meta|precision|ns|float32 or meta|precision|ns::NAME|float32
+                    if (parts[3] != "float32" && parts[3] != "float64") {
+                        std::cerr << "[WebCC] Error: Unknown precision '" << parts[3] << "' at line " << line_num << std::endl;
+                        exit(1);
+                    }
+                    out.precision[parts[2]] = parts[3];
+                } else if (parts.size() >= 3 && parts[1] == "bind") {
+                    // meta|bind|HandleType
+                    out.bound_types.push_back(parts[2]);
+                } else {
+                    std::cerr << "[WebCC] Warning: Skipping unknown meta line " << line_num << ": " << line << std::endl;
+                }
+                continue;
+            }
+
             if (parts.size() < 4)
             {
                 std::cerr << "[WebCC] Warning: Skipping malformed line " << line_num << ": " << line << std::endl;
@@ -283,14 +348,6 @@ namespace webcc
             std::string kind = "command";
             int name_idx = 1;
 
-            if (ns == "meta") {
-                if (parts.size() >= 4 && parts[1] == "inherit") {
-                    // meta|inherit|Derived|Base
-                    out.handle_inheritance[parts[2]] = parts[3];
-                }
-                continue;
-            }
-
             // Check if second column is explicit kind
             if (parts[1] == "event" || parts[1] == "command")
             {
@@ -300,7 +357,7 @@ namespace webcc
 
             if (kind == "event")
             {
-                // NAMESPACE|event|NAME|ARGS
+                // NAMESPACE|event|NAME|ARGS[|coalesce=last|accumulate|batch=N]
                 if (parts.size() <= name_idx + 1)
                     continue;
                 
@@ -350,6 +407,54 @@ namespace webcc
 
                     e.params.push_back(p);
                 }
+
+                if (parts.size() > name_idx + 2)
+                {
+                    const std::string &opt = parts[name_idx + 2];
+                    if (opt == "coalesce=last")
+                        e.coalesce = Coalesce::Last;
+                    else if (opt == "coalesce=accumulate")
+                        e.coalesce = Coalesce::Accumulate;
+                    else if (opt.rfind("batch=", 0) == 0)
+                    {
+                        int n = std::atoi(opt.c_str() + 6);
+                        if (n < 1 || n > 1024)
+                        {
+                            std::cerr << "[WebCC] Error: Event '" << event_name << "' needs a batch size from 1 to 1024 at line " << line_num << std::endl;
+                            exit(1);
+                        }
+                        e.batch = (uint16_t)n;
+                    }
+                    else
+                    {
+                        std::cerr << "[WebCC] Error: Unknown event option '" << opt << "' at line " << line_num << std::endl;
+                        exit(1);
+                    }
+                    // Coalescing rewrites the queued event in place, so it must
+                    // keep its size; accumulating needs fields that add up, and
+                    // a batch column needs a fixed-size type.
+                    // Header, count and the 4-byte --stats stamp, so a schema
+                    // that fits here fits in every build.
+                    uint32_t block = 12;
+                    for (const auto &p : e.params)
+                    {
+                        bool numeric = p.type == "int32" || p.type == "uint32" || p.type == "float32" || p.type == "float64";
+                        block += (p.type == "float64" ? 8 * e.batch + 4 : 4 * e.batch);
+                        if (p.type == "string" || ((e.coalesce == Coalesce::Accumulate || e.batch) && !numeric))
+                        {
+                            std::cerr << "[WebCC] Error: Event '" << event_name << "' cannot use " << opt
+                                      << " with a " << p.type << " param at line " << line_num << std::endl;
+                            exit(1);
+                        }
+                    }
+                    // The record size is a u16 in the ring.
+                    if (e.batch && block > 0xFFFF)
+                    {
+                        std::cerr << "[WebCC] Error: Event '" << event_name << "' makes " << block
+                                  << "-byte blocks with " << opt << " (max 65535) at line " << line_num << std::endl;
+                        exit(1);
+                    }
+                }
                 out.events.push_back(e);
             }
             else
@@ -383,6 +488,12 @@ namespace webcc
                 SchemaCommand c;
                 c.ns = ns;
                 c.name = cmd_name;
+                if (current_cmd_opcode >= OP_BUILTIN_FIRST)
+                {
+                    std::cerr << "[WebCC] Error: Too many commands at line " << line_num << "; opcodes from "
+                              << (int)OP_BUILTIN_FIRST << " up are reserved for the runtime" << std::endl;
+                    exit(1);
+                }
                 c.opcode = current_cmd_opcode++;
                 c.func_name = func_name;
                 // types
@@ -448,10 +559,45 @@ namespace webcc
                 out.commands.push_back(c);
             }
         }
+        if (!out.bound_types.empty() && out.wire_version < 2)
+        {
+            std::cerr << "[WebCC] Error: meta|bind requires meta|wire|compact" << std::endl;
+            exit(1);
+        }
+        if (out.bound_types.size() > MAX_BIND_SLOTS)
+        {
+            std::cerr << "[WebCC] Error: At most " << MAX_BIND_SLOTS << " meta|bind handle types are supported" << std::endl;
+            exit(1);
+        }
+        resolve_wire(out);
         std::cout << "[WebCC] Loaded " << out.commands.size() << " commands and " << out.events.size() << " events." << std::endl;
         return out;
     }
 
+    void resolve_wire(SchemaDefs &defs)
+    {
+        for (auto &c : defs.commands)
+        {
+            c.compact = defs.wire_version >= 2;
+
+            std::string precision;
+            auto it = defs.precision.find(c.ns + "::" + c.name);
+            if (it == defs.precision.end())
+                it = defs.precision.find(c.ns);
+            if (it != defs.precision.end())
+                precision = it->second;
+            c.narrow_floats = precision == "float32";
+
+            c.bind_slot = -1;
+            if (c.compact && c.return_type.empty() && !c.params.empty() && c.params[0].type == "handle")
+            {
+                for (size_t i = 0; i < defs.bound_types.size(); ++i)
+                    if (defs.bound_types[i] == c.params[0].handle_type)
+                        c.bind_slot = (int)i;
+            }
+        }
+    }
+
     SchemaDefs load_defs_from_schema()
     {
         // Legacy function - now just returns empty, use load_defs_cached instead
@@ -26,6 +26,20 @@ namespace webcc
         std::string action;              // JS action body (using arg0.. or custom names)
         std::string return_type;         // Optional return type: handle, int32, string, etc.
         std::string return_handle_type;  // For handle return types: DOMElement, CanvasContext2D, etc.
+
+        // Wire encoding, resolved from the schema's meta lines (see resolve_wire).
+        bool compact = false;       // encoded with the v2 (compact) wire format
+        bool narrow_floats = false; // float64 params travel as float32
+        int bind_slot = -1;         // first param is a bound handle (register slot), or -1
+    };
+
+    // How app.js folds a new event into the previous one when that is of the
+    // same type and C++ has not read it yet (`|coalesce=...` on an event line).
+    enum class Coalesce : uint8_t
+    {
+        None,       // every event is queued
+        Last,       // overwrite it in place: latest position wins
+        Accumulate, // add the fields to it: deltas sum up
     };
 
     // Represents an event definition from `schema.def`.
@@ -35,6 +49,11 @@ namespace webcc
         std::string name;
         uint8_t opcode;
         std::vector<SchemaParam> params;
+        Coalesce coalesce = Coalesce::None;
+        // `|batch=N`: pushes are appended to the last queued block of this
+        // event while C++ has not read it, up to N samples. A block stores
+        // each param as a column of N values (struct of arrays). 0 = off.
+        uint16_t batch = 0;
     };
 
     // Holds all command and event definitions.
@@ -43,8 +62,17 @@ namespace webcc
         std::vector<SchemaCommand> commands;
         std::vector<SchemaEvent> events;
         std::map<std::string, std::string> handle_inheritance;
+
+        // Wire format options (meta|wire, meta|precision, meta|bind).
+        int wire_version = 1;                         // 2 = compact encoding
+        std::map<std::string, std::string> precision; // "ns" or "ns::NAME" -> float32/float64
+        std::vector<std::string> bound_types;         // handle types with a bind register, by slot
     };
 
+    // Apply the wire options in `defs` to every command (compact, narrow_floats,
+    // bind_slot). A command-level precision overrides its namespace's.
+    void resolve_wire(SchemaDefs &defs);
+
     // Loads and parses the command and event definitions from a file (e.g., schema.def).
     SchemaDefs load_defs(const std::string &path);
 
@@ -1,71 +1,204 @@
 #include "command_buffer.h"
+#include "webcc/core/allocator.h"
 
 namespace webcc {
 
 namespace {
     constexpr size_t MAX_BUFFER_SIZE = 1024 * 1024; // 1MB
-    alignas(8) static uint8_t g_buffer[MAX_BUFFER_SIZE];
-    static size_t g_offset = 0;
-}
+    constexpr size_t GROW_SEGMENT = 1024 * 1024;
+
+    // Two buffers used ping-pong: the producer encodes into one while the
+    // other keeps the last flushed frame intact.
+    alignas(8) static uint8_t g_storage[2][MAX_BUFFER_SIZE];
+
+    struct Slot {
+        uint8_t* base;       // g_storage[i], or a heap block once grown
+        size_t capacity;
+        uint8_t* fixed;      // the static buffer this slot falls back to
+    };
+    static Slot g_slots[2] = {
+        {g_storage[0], MAX_BUFFER_SIZE, g_storage[0]},
+        {g_storage[1], MAX_BUFFER_SIZE, g_storage[1]},
+    };
+    static Slot* g_active = &g_slots[0];
+    static const uint8_t* g_snapshot = g_storage[1];
+    static size_t g_snapshot_size = 0;
 
-void CommandBuffer::push_u32(uint32_t v) {
-    if (g_offset + 4 <= MAX_BUFFER_SIZE) {
-        g_buffer[g_offset++] = v & 0xFF;
-        g_buffer[g_offset++] = (v >> 8) & 0xFF;
-        g_buffer[g_offset++] = (v >> 16) & 0xFF;
-        g_buffer[g_offset++] = (v >> 24) & 0xFF;
+    // Pending commands that reset() must keep, as byte ranges of the active
+    // buffer. Cleared by swap(), since a flush sends them.
+    struct Span {
+        uint32_t begin, end;
+    };
+    static Span* g_kept = nullptr;
+    static size_t g_kept_count = 0;
+    static size_t g_kept_capacity = 0;
+
+    static OverflowPolicy g_policy = OverflowPolicy::Flush;
+    static CommandBufferStats g_stats = {0, 0, 0, MAX_BUFFER_SIZE, 0};
+
+    void note_high_water(size_t used) {
+        if (used > g_stats.high_water) g_stats.high_water = used;
     }
-}
 
-void CommandBuffer::push_i32(int32_t v) {
-    push_u32(static_cast<uint32_t>(v));
-}
+    void activate(Slot* slot, size_t used) {
+        g_active = slot;
+        detail::cmd_cursor = slot->base + used;
+        detail::cmd_limit = slot->base + slot->capacity;
+        g_stats.capacity = slot->capacity;
+    }
 
-void CommandBuffer::push_float(float v) {
-    uint32_t u;
-    __builtin_memcpy(&u, &v, 4);
-    push_u32(u);
-}
+    // Enlarge the active buffer so `extra` more bytes fit, keeping pending
+    // commands.
+    bool grow(size_t extra) {
+        Slot* slot = g_active;
+        size_t used = (size_t)(detail::cmd_cursor - slot->base);
+        size_t need = used + extra;
+        size_t cap = slot->capacity;
+        while (cap < need) cap += GROW_SEGMENT;
 
-void CommandBuffer::push_double(double v) {
-    // Align to 8 bytes before writing double
-    if (g_offset % 8 != 0) {
-        size_t pad = 8 - (g_offset % 8);
-        for(size_t k=0; k<pad; ++k) {
-            if(g_offset < MAX_BUFFER_SIZE) g_buffer[g_offset++] = 0;
+        uint8_t* block;
+        if (slot->base == slot->fixed) {
+            block = (uint8_t*)webcc::malloc(cap);
+            if (!block) return false;
+            __builtin_memcpy(block, slot->base, used);
+        } else {
+            block = (uint8_t*)webcc::realloc(slot->base, cap);
+            if (!block) return false;
         }
+        slot->base = block;
+        slot->capacity = cap;
+        activate(slot, used);
+        g_stats.grows++;
+        return true;
     }
-    uint64_t u;
-    __builtin_memcpy(&u, &v, 8);
-    // Push as two 32-bit values (little-endian)
-    push_u32(u & 0xFFFFFFFF);
-    push_u32(u >> 32);
-}
-
-void CommandBuffer::push_string(const char* str, size_t len) {
-    push_u32((uint32_t)len);
-    
-    if (g_offset + len <= MAX_BUFFER_SIZE) {
-        for(size_t k=0; k<len; ++k) g_buffer[g_offset++] = str[k];
+
+    bool fits(size_t n) { return (size_t)(detail::cmd_limit - detail::cmd_cursor) >= n; }
+}
+
+namespace detail {
+    int32_t cmd_bound[MAX_BIND_SLOTS] = {INT32_MIN, INT32_MIN, INT32_MIN, INT32_MIN};
+    uint8_t* cmd_cursor = g_storage[0];
+    uint8_t* cmd_limit = g_storage[0] + MAX_BUFFER_SIZE;
+}
+
+uint8_t* CommandBuffer::reserve_slow(size_t max_bytes) {
+    if (g_policy == OverflowPolicy::Flush && detail::cmd_cursor != g_active->base) {
+        detail::flush_for(FlushReason::Overflow);
+        g_stats.overflow_flushes++;
+        if (fits(max_bytes)) return detail::cmd_cursor;
     }
-    
-    // Pad to 4 bytes
-    size_t pad = (4 - (len % 4)) % 4;
-    for(size_t k=0; k<pad; ++k) {
-        if(g_offset < MAX_BUFFER_SIZE) g_buffer[g_offset++] = 0;
+    // Grow policy, or a single command larger than the whole buffer.
+    if (grow(max_bytes)) return detail::cmd_cursor;
+
+    // Out of memory: flushing is the last way to make room.
+    if (detail::cmd_cursor != g_active->base) {
+        detail::flush_for(FlushReason::Overflow);
+        g_stats.overflow_flushes++;
+        if (fits(max_bytes)) return detail::cmd_cursor;
     }
+    g_stats.dropped++;
+    return nullptr;
 }
 
 const uint8_t* CommandBuffer::data(){
-    return g_buffer;
+    return g_active->base;
 }
 
 size_t CommandBuffer::size(){
-    return g_offset;
+    return (size_t)(detail::cmd_cursor - g_active->base);
+}
+
+size_t CommandBuffer::capacity(){
+    return g_active->capacity;
+}
+
+void CommandBuffer::commit_kept(CommandCursor c){
+    uint32_t begin = (uint32_t)size();
+    commit(c);
+    if (g_kept_count == g_kept_capacity) {
+        size_t cap = g_kept_capacity ? g_kept_capacity * 2 : 16;
+        Span* spans = (Span*)webcc::realloc(g_kept, cap * sizeof(Span));
+        // Out of memory: the command is still sent, unless reset() drops it.
+        if (!spans) return;
+        g_kept = spans;
+        g_kept_capacity = cap;
+    }
+    g_kept[g_kept_count++] = {begin, (uint32_t)size()};
 }
 
 void CommandBuffer::reset(){
-    g_offset = 0;
+    note_high_water(size());
+#ifdef WEBCC_STATS
+    detail::stats_discarded();
+#endif
+    // Slide the kept commands down to the front, in order.
+    uint8_t* base = g_active->base;
+    uint32_t used = 0;
+    for (size_t i = 0; i < g_kept_count; ++i) {
+        Span& s = g_kept[i];
+        uint32_t len = s.end - s.begin;
+        __builtin_memmove(base + used, base + s.begin, len);
+        s = {used, used + len};
+        used += len;
+#ifdef WEBCC_STATS
+        detail::stats_command(base + s.begin, base + s.end);
+#endif
+    }
+    detail::cmd_cursor = base + used;
+    detail::unbind_all();
+}
+
+void CommandBuffer::swap(){
+    size_t used = size();
+    note_high_water(used);
+    g_snapshot = g_active->base;
+    g_snapshot_size = used;
+    activate(g_active == &g_slots[0] ? &g_slots[1] : &g_slots[0], 0);
+    g_kept_count = 0;
+    detail::unbind_all();
+}
+
+const uint8_t* CommandBuffer::snapshot_data(){
+    return g_snapshot;
+}
+
+size_t CommandBuffer::snapshot_size(){
+    return g_snapshot_size;
+}
+
+void CommandBuffer::set_overflow_policy(OverflowPolicy policy){
+    g_policy = policy;
+}
+
+OverflowPolicy CommandBuffer::overflow_policy(){
+    return g_policy;
+}
+
+const CommandBufferStats& CommandBuffer::stats(){
+    return g_stats;
+}
+
+void CommandBuffer::trim(){
+    Slot* slot = g_active;
+    if (slot->base != slot->fixed && size() == 0) {
+        webcc::free(slot->base);
+        slot->base = slot->fixed;
+        slot->capacity = MAX_BUFFER_SIZE;
+        activate(slot, 0);
+    }
+
+    // The other slot holds the snapshot. Its grown block can go too when the
+    // snapshot fits the static buffer: it moves there first.
+    Slot* other = slot == &g_slots[0] ? &g_slots[1] : &g_slots[0];
+    if (other->base == other->fixed) return;
+    if (other->base == g_snapshot) {
+        if (g_snapshot_size > MAX_BUFFER_SIZE) return;
+        __builtin_memcpy(other->fixed, other->base, g_snapshot_size);
+        g_snapshot = other->fixed;
+    }
+    webcc::free(other->base);
+    other->base = other->fixed;
+    other->capacity = MAX_BUFFER_SIZE;
 }
 
 } // namespace webcc
@@ -80,10 +213,16 @@ extern "C" void webcc_js_flush(uintptr_t ptr, size_t size) {}
 
 namespace webcc {
     void flush() {
+#ifdef WEBCC_STATS
+        FlushReason reason = detail::stats_take_reason();
+#endif
         size_t s = CommandBuffer::size();
         if (s == 0) return;
         webcc_js_flush(reinterpret_cast<uintptr_t>(CommandBuffer::data()), s);
-        CommandBuffer::reset();
+#ifdef WEBCC_STATS
+        detail::stats_flushed(reason);
+#endif
+        CommandBuffer::swap();
     }
 }
 
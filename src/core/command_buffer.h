@@ -5,23 +5,227 @@
 
 namespace webcc {
 
+// Opcodes from OP_BUILTIN_FIRST up are reserved for commands the runtime
+// emits itself; schema commands are numbered below it.
+constexpr uint8_t OP_BUILTIN_FIRST = 0xF0;
+
+// Compact (v2) wire format only: [OP_BIND][u8 slot][i32 handle] points bind
+// register `slot` at `handle`. Commands whose first param is a bound handle
+// type (meta|bind in schema.def) omit it and use the register instead.
+constexpr uint8_t OP_BIND = 0xFE;
+constexpr size_t BIND_SIZE = 6;
+constexpr size_t MAX_BIND_SLOTS = 4;
+
+// [OP_INTERN][u32 id][string]: register an interned string (see intern.h).
+// String params then carry INTERNED_BIT | id in their length field.
+constexpr uint8_t OP_INTERN = 0xFF;
+
+// Retained display lists (see display_list.h). [OP_BEGIN_RECORD][u32 id]
+// starts copying the executed commands into list `id`, [OP_END_RECORD] closes
+// it, [OP_REPLAY][u32 id] runs the copy and [OP_DISCARD_LIST][u32 id] frees it.
+constexpr uint8_t OP_BEGIN_RECORD = 0xFD;
+constexpr uint8_t OP_END_RECORD = 0xFC;
+constexpr uint8_t OP_REPLAY = 0xFB;
+constexpr uint8_t OP_DISCARD_LIST = 0xFA;
+
+// Why a flush ran. Only the instrumented build (webcc --stats, which defines
+// WEBCC_STATS) records it; see webcc/core/stats.h.
+enum class FlushReason : uint8_t {
+    Explicit, // the app called webcc::flush()
+    Overflow, // the buffer filled up mid-frame
+    Getter,   // a return-value command needed the pending commands run first
+    InlineJs, // likewise, for a WEBCC_JS function
+};
+constexpr size_t FLUSH_REASON_COUNT = 4;
+
+void flush();
+
+namespace detail {
+#ifdef WEBCC_STATS
+    // Instrumentation hooks, defined in stats.cc. flush() takes the pending
+    // reason (Explicit unless stats_request() set another) and reports back
+    // once JS has run a non-empty batch.
+    void stats_command(const uint8_t* begin, const uint8_t* end);
+    void stats_request(FlushReason reason);
+    FlushReason stats_take_reason();
+    void stats_flushed(FlushReason reason);
+    // next_event() handed out an event JS pushed at `stamp_us`.
+    void stats_event(uint8_t opcode, uint32_t stamp_us);
+    void stats_discarded();
+#endif
+
+    // The flush done before a synchronous call into JS, so JS sees the
+    // commands issued ahead of it. Same as flush() unless instrumented.
+    inline void flush_for(FlushReason reason) {
+#ifdef WEBCC_STATS
+        stats_request(reason);
+#else
+        (void)reason;
+#endif
+        flush();
+    }
+
+    // Last handle bound per slot in the current batch; reset on every flush so
+    // each batch is self-contained.
+    extern int32_t cmd_bound[MAX_BIND_SLOTS];
+
+    // Write position and end of the command buffer. Defined in
+    // command_buffer.cc; visible here so the capacity check in the generated
+    // wrappers inlines down to a compare and a branch.
+    extern uint8_t* cmd_cursor;
+    extern uint8_t* cmd_limit;
+
+    // Forget the bind registers, so the next bound command re-emits its BIND.
+    inline void unbind_all() {
+        for (size_t i = 0; i < MAX_BIND_SLOTS; ++i) cmd_bound[i] = INT32_MIN;
+    }
+}
+
+// Unchecked writer over a span reserved with CommandBuffer::reserve().
+// The reservation covers the worst-case size of the whole command, so each
+// store is a plain little-endian word write with no bounds test.
+struct CommandCursor {
+    uint8_t* p;
+
+    explicit operator bool() const { return p != nullptr; }
+
+    void u32(uint32_t v) { __builtin_memcpy(p, &v, 4); p += 4; }
+    void i32(int32_t v) { __builtin_memcpy(p, &v, 4); p += 4; }
+    void f32(float v) { __builtin_memcpy(p, &v, 4); p += 4; }
+
+    // Doubles sit on an 8-byte boundary. Every other field keeps the cursor
+    // 4-aligned, so at most one zero word of padding is needed.
+    void f64(double v) {
+        if ((uintptr_t)p & 4) u32(0);
+        __builtin_memcpy(p, &v, 8);
+        p += 8;
+    }
+
+    // Length-prefixed bytes, zero-padded to a 4-byte boundary. `ref` is
+    // OR-ed into the prefix (an interned id, with len == 0).
+    void str(const char* s, uint32_t len, uint32_t ref = 0) {
+        u32(len | ref);
+        // Zero the last word first and copy over it: one store pads the tail.
+        if (len & 3) { uint32_t zero = 0; __builtin_memcpy(p + (len & ~3u), &zero, 4); }
+        if (len) __builtin_memcpy(p, s, len);
+        p += pad4(len);
+    }
+
+    // Compact (v2) encoding: narrow ints take their own size and nothing is
+    // aligned or padded.
+    void u8(uint8_t v) { *p++ = v; }
+    void f64_packed(double v) { __builtin_memcpy(p, &v, 8); p += 8; }
+    void str_packed(const char* s, uint32_t len, uint32_t ref = 0) {
+        u32(len | ref);
+        if (len) __builtin_memcpy(p, s, len);
+        p += len;
+    }
+
+    // Emit a BIND for `slot` unless the register already holds `handle`.
+    // Reserve BIND_SIZE for it either way.
+    void bind(uint8_t slot, int32_t handle) {
+        if (detail::cmd_bound[slot] == handle) return;
+        detail::cmd_bound[slot] = handle;
+        u8(OP_BIND);
+        u8(slot);
+        i32(handle);
+    }
+
+    // Bytes a string of `len` occupies after its length prefix.
+    static constexpr size_t pad4(size_t len) { return (len + 3) & ~(size_t)3; }
+};
+
+// What reserve() does when a command does not fit in the space left.
+enum class OverflowPolicy : uint8_t {
+    // Flush the pending commands to JS mid-frame, then write into the emptied
+    // buffer. Keeps memory fixed; the default.
+    Flush,
+    // Enlarge the buffer (heap-allocated, in 1MB segments) and keep batching
+    // until the next explicit flush.
+    Grow,
+};
+
+// Counters for how often the overflow path runs. All monotonic except
+// `capacity`, which reflects the current buffer.
+struct CommandBufferStats {
+    uint32_t overflow_flushes; // flushes forced by a full buffer
+    uint32_t grows;            // times the buffer was enlarged
+    uint32_t dropped;          // commands discarded (no flush or growth helped)
+    size_t capacity;           // current buffer size in bytes
+    size_t high_water;         // most bytes ever pending at once
+};
+
 struct CommandBuffer {
+    // Reserve room for one whole command of at most `max_bytes`. When it does
+    // not fit, the overflow policy flushes or grows first; a null cursor is
+    // returned only if neither helped, so the stream never holds a partial
+    // command. Pair every successful reserve() with commit().
+    static CommandCursor reserve(size_t max_bytes) {
+        uint8_t* p = detail::cmd_cursor;
+        if ((size_t)(detail::cmd_limit - p) < max_bytes) return {reserve_slow(max_bytes)};
+        return {p};
+    }
+
+    // Publish the bytes written through `c`.
+    static void commit(CommandCursor c) {
+#ifdef WEBCC_STATS
+        detail::stats_command(detail::cmd_cursor, c.p);
+#endif
+        detail::cmd_cursor = c.p;
+    }
+
+    // Like commit(), but the command survives reset(). For built-ins whose
+    // effect C++ has already recorded (an intern id handed out, a display
+    // list opened or closed): dropping them would leave JS out of step.
+    static void commit_kept(CommandCursor c);
+
+    // Single values, each its own reservation. An overflow flush may land
+    // between two calls, so a command built from several of these can be
+    // split across batches; encode whole commands with reserve()/commit()
+    // or webcc::push_command().
     // Append a 32-bit integer (aligned)
-    static void push_u32(uint32_t v);
-    static void push_i32(int32_t v);
-    static void push_float(float v);
-    static void push_double(double v);
+    static void push_u32(uint32_t v) { if (auto c = reserve(4)) { c.u32(v); commit(c); } }
+    static void push_i32(int32_t v) { if (auto c = reserve(4)) { c.i32(v); commit(c); } }
+    static void push_float(float v) { if (auto c = reserve(4)) { c.f32(v); commit(c); } }
+    static void push_double(double v) { if (auto c = reserve(12)) { c.f64(v); commit(c); } }
 
     // Append a string (aligned)
-    static void push_string(const char* str, size_t len);
+    static void push_string(const char* str, size_t len) {
+        if (auto c = reserve(4 + CommandCursor::pad4(len))) { c.str(str, (uint32_t)len); commit(c); }
+    }
 
-    // Accessors used by the JS runtime (exported C symbols call these)
-    // These access the "snapshot" buffer which is stable until
-    // `reset()` is called. Writers append to the producer buffer and a
-    // swap is performed when JS asks for the buffer ptr.
+    // The producer buffer: commands encoded since the last flush.
     static const uint8_t* data();
     static size_t size();
+    static size_t capacity();
+    // Discard the pending commands. Those committed with commit_kept() are
+    // moved to the front instead, in order, and still go out on the next
+    // flush.
     static void reset();
+
+    // Two buffers are used ping-pong. swap() (called by flush() once JS has
+    // the bytes) turns the producer buffer into the "snapshot" and continues
+    // encoding into the other one. The snapshot is the last flushed batch and
+    // stays valid, uncopied, until the following swap() or trim(), so it can
+    // be decoded asynchronously or replayed while the next frame is being
+    // encoded.
+    static void swap();
+    static const uint8_t* snapshot_data();
+    static size_t snapshot_size();
+
+    static void set_overflow_policy(OverflowPolicy policy);
+    static OverflowPolicy overflow_policy();
+    static const CommandBufferStats& stats();
+
+    // Return grown storage to the heap and go back to the static buffers.
+    // The producer buffer is only trimmed while it is empty (i.e. right
+    // after a flush). A snapshot in grown storage is copied to its static
+    // buffer if it fits, so snapshot_data() may move; a larger one is kept.
+    static void trim();
+
+private:
+    // Out-of-line path taken when a reservation does not fit.
+    static uint8_t* reserve_slow(size_t max_bytes);
 };
 
 } // namespace webcc
@@ -1,13 +1,19 @@
 #include "event_buffer.h"
+#include "command_buffer.h"
+#include "webcc/core/allocator.h"
 
 namespace webcc
 {
 
-    constexpr size_t EVENT_BUFFER_SIZE = 1024 * 1024; // 1MB
+    constexpr uint32_t EVENT_BUFFER_SIZE = 1024 * 1024; // 1MB
+    static_assert((EVENT_BUFFER_SIZE & (EVENT_BUFFER_SIZE - 1)) == 0, "the ring is indexed by mask");
     // Align to 8 bytes so that JS Float64Array can access it directly
     alignas(8) static uint8_t g_event_buffer[EVENT_BUFFER_SIZE];
-    static uint32_t g_event_offset = 0;
-    static uint32_t g_read_offset = 0;
+    alignas(64) static EventRing g_ring = {};
+
+    // Out-of-band payloads of the event handed out last.
+    static void *g_payloads[15];
+    static uint32_t g_payload_count = 0;
 
     extern "C" uint8_t *webcc_event_buffer_ptr()
     {
@@ -16,7 +22,7 @@ namespace webcc
 
     extern "C" uint32_t *webcc_event_offset_ptr()
     {
-        return &g_event_offset;
+        return &g_ring.head;
     }
 
     extern "C" uint32_t webcc_event_buffer_capacity()
@@ -24,10 +30,86 @@ namespace webcc
         return EVENT_BUFFER_SIZE;
     }
 
+    extern "C" void *webcc_event_alloc(uint32_t size)
+    {
+        return webcc::malloc(size);
+    }
+
+    // Plain loads and stores on single-threaded wasm; real acquire/release
+    // once the memory is shared.
+    static uint32_t load_acquire(const uint32_t &v) { return __atomic_load_n(&v, __ATOMIC_ACQUIRE); }
+    static void store_release(uint32_t &v, uint32_t x) { __atomic_store_n(&v, x, __ATOMIC_RELEASE); }
+
+    // Stop the producer from folding more events into the record at `pos`
+    // (see EVENT_OPEN), waiting out a fold in progress.
+    static void close_record(uint32_t pos)
+    {
+        uint32_t *word = (uint32_t *)(g_event_buffer + pos);
+        const uint32_t open = (uint32_t)EVENT_OPEN << 8, busy = (uint32_t)EVENT_BUSY << 8;
+        uint32_t h = __atomic_load_n(word, __ATOMIC_ACQUIRE);
+        while (h & open) {
+            if (h & busy)
+                h = __atomic_load_n(word, __ATOMIC_ACQUIRE);
+            else if (__atomic_compare_exchange_n(word, &h, h & ~open, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                break;
+        }
+    }
+
+    static uint32_t payload_count(uint32_t pos)
+    {
+        return g_event_buffer[pos + 1] >> 4;
+    }
+
+    static uint32_t record_len(uint32_t pos)
+    {
+        return (uint32_t)g_event_buffer[pos + 2] | ((uint32_t)g_event_buffer[pos + 3] << 8);
+    }
+
+    // Payload pointers are wasm32 addresses.
+    static void *payload_ptr(uint32_t at)
+    {
+        return (void *)(uintptr_t)*(const uint32_t *)(g_event_buffer + at);
+    }
+
+    static void free_payloads()
+    {
+        for (uint32_t i = 0; i < g_payload_count; ++i)
+            webcc::free(g_payloads[i]);
+        g_payload_count = 0;
+    }
+
     void reset_event_buffer()
     {
-        g_event_offset = 0;
-        g_read_offset = 0;
+        free_payloads();
+        // Free the payloads of the records being dropped, as far as they parse.
+        uint32_t head = load_acquire(g_ring.head);
+        while (g_ring.read != head) {
+            uint32_t pos = g_ring.read & (EVENT_BUFFER_SIZE - 1);
+            if (g_event_buffer[pos] == 0) {
+                g_ring.read += EVENT_BUFFER_SIZE - pos;
+                continue;
+            }
+            close_record(pos);
+            uint32_t len = record_len(pos), n = payload_count(pos);
+            if (len < 4 + 4 * n || len > head - g_ring.read || pos + len > EVENT_BUFFER_SIZE)
+                break;
+            for (uint32_t i = 0; i < n; ++i)
+                webcc::free(payload_ptr(pos + len - 4 * (n - i)));
+            g_ring.read += len;
+        }
+        g_ring.read = head;
+        store_release(g_ring.tail, g_ring.read);
+    }
+
+    bool adopt_event_payload(const void *data)
+    {
+        for (uint32_t i = 0; i < g_payload_count; ++i) {
+            if (g_payloads[i] == data) {
+                g_payloads[i] = g_payloads[--g_payload_count];
+                return true;
+            }
+        }
+        return false;
     }
 
     const uint8_t *event_buffer_data()
@@ -37,37 +119,72 @@ namespace webcc
 
     uint32_t event_buffer_size()
     {
-        return g_event_offset;
+        return load_acquire(g_ring.head) - g_ring.read;
+    }
+
+    EventBufferStats event_buffer_stats()
+    {
+        return {EVENT_BUFFER_SIZE, event_buffer_size(), g_ring.high_water, g_ring.dropped};
+    }
+
+    // Relaxed read-modify-writes: JS only ever reads `muted`.
+    void subscribe_event(uint8_t opcode)
+    {
+        __atomic_fetch_and(&g_ring.muted[opcode >> 5], ~(1u << (opcode & 31)), __ATOMIC_RELAXED);
+    }
+
+    void unsubscribe_event(uint8_t opcode)
+    {
+        __atomic_fetch_or(&g_ring.muted[opcode >> 5], 1u << (opcode & 31), __ATOMIC_RELAXED);
+    }
+
+    bool event_subscribed(uint8_t opcode)
+    {
+        return !(g_ring.muted[opcode >> 5] & (1u << (opcode & 31)));
     }
 
     bool next_event(uint8_t& opcode, const uint8_t** data_ptr, uint32_t& data_len) {
-        uint32_t size = g_event_offset;
-        if (g_read_offset >= size) {
-            reset_event_buffer();
-            return false;
-        }
-        
-        // Format: [Opcode:1][Pad:1][Size:2][Data...]
-        if (g_read_offset + 4 > size) {
-             // Malformed or incomplete? Reset.
-            reset_event_buffer();
-            return false;
-        }
+        // The app is done with the event handed out last time.
+        free_payloads();
+        store_release(g_ring.tail, g_ring.read);
 
-        opcode = g_event_buffer[g_read_offset];
-        uint16_t event_len = (uint16_t)g_event_buffer[g_read_offset + 2] | ((uint16_t)g_event_buffer[g_read_offset + 3] << 8);
-        
-        if (g_read_offset + event_len > size) {
-             // Incomplete event?
-            reset_event_buffer();
-            return false;
-        }
+        uint32_t head = load_acquire(g_ring.head);
+        while (g_ring.read != head) {
+            uint32_t pos = g_ring.read & (EVENT_BUFFER_SIZE - 1);
+            uint8_t op = g_event_buffer[pos];
+            if (op == 0) {
+                // Skip marker: the next record starts at offset 0.
+                g_ring.read += EVENT_BUFFER_SIZE - pos;
+                continue;
+            }
 
-        *data_ptr = g_event_buffer + g_read_offset + 4;
-        data_len = event_len - 4;
+            // Format: [Opcode:1][Flags:1][Size:2][Stamp:4, if EVENT_STAMPED][Data...][Payload ptrs]
+            close_record(pos);
+            uint32_t event_len = record_len(pos);
+            uint32_t header = (g_event_buffer[pos + 1] & EVENT_STAMPED) ? 8 : 4;
+            uint32_t payloads = payload_count(pos);
+            if (event_len < header + 4 * payloads || event_len > head - g_ring.read || pos + event_len > EVENT_BUFFER_SIZE) {
+                // Malformed: drop everything queued rather than misparse it.
+                reset_event_buffer();
+                return false;
+            }
+#ifdef WEBCC_STATS
+            if (header == 8)
+                detail::stats_event(op, *(const uint32_t*)(g_event_buffer + pos + 4));
+#endif
 
-        g_read_offset += event_len;
-        return true;
+            for (uint32_t i = 0; i < payloads; ++i)
+                g_payloads[i] = payload_ptr(pos + event_len - 4 * (payloads - i));
+            g_payload_count = payloads;
+
+            opcode = op;
+            *data_ptr = g_event_buffer + pos + header;
+            data_len = event_len - header - 4 * payloads;
+            g_ring.read += event_len;
+            return true;
+        }
+        store_release(g_ring.tail, g_ring.read);
+        return false;
     }
 
 }
@@ -5,15 +5,93 @@
 namespace webcc
 {
 
-    // Accessors for JS
+    // The event channel is a single-producer/single-consumer byte ring. JS
+    // (the producer) appends records at `head`; C++ (the consumer) reads them
+    // at `tail`. Both are free-running byte counters, so `head - tail` is the
+    // number of bytes queued even after they wrap, and a slot's offset is
+    // `counter & (capacity - 1)`.
+    //
+    // Record: [Opcode:1][Flags:1][Size:2][Data...], 4-byte aligned. A record
+    // never straddles the end of the ring: when one does not fit there, the
+    // producer writes opcode 0 ("skip to the start") and continues at offset 0.
+    // With EVENT_STAMPED in Flags (instrumented builds, `webcc --stats`), a
+    // u32 push time in microseconds on the performance.now() clock comes
+    // before Data; next_event() feeds it to webcc::stats::event_latency().
+    //
+    // A string param longer than EVENT_INLINE_MAX bytes is not copied into
+    // the ring. JS writes it once into a heap block from webcc_event_alloc(),
+    // and the field holds [len | EVENT_DETACHED][ptr] instead of the bytes.
+    // Flags bits 4-7 count such blocks, and their pointers end the record, so
+    // next_event() can free them once the app is done with the event.
+    //
+    // Each side writes only its own cache line, with 32-bit aligned fields,
+    // so the same layout works with Atomics when the producer is a Worker
+    // writing into a shared memory. Publishing is ordered: the producer
+    // stores `head` after the record bytes, the consumer stores `tail` only
+    // once the app is done with an event (on the next poll).
+    //
+    // Coalescing and batched events are the exception: JS folds a new event
+    // into the record it published last. Such records carry EVENT_OPEN, and
+    // both sides claim the 32-bit header word with a compare-exchange. The
+    // producer sets EVENT_BUSY while it writes; next_event() waits for that
+    // to clear and then clears EVENT_OPEN before reading, after which the
+    // record is never touched again.
+    constexpr uint8_t EVENT_STAMPED = 1;
+    constexpr uint8_t EVENT_OPEN = 2;
+    constexpr uint8_t EVENT_BUSY = 4;
+    constexpr uint32_t EVENT_INLINE_MAX = 4096;
+    constexpr uint32_t EVENT_DETACHED = 0x80000000u;
+
+    struct EventRing
+    {
+        // Producer line (JS).
+        uint32_t head;       // bytes ever written
+        uint32_t high_water; // most bytes queued at once
+        uint32_t dropped;    // events discarded because the ring was full
+        uint32_t producer_pad[13];
+        // Consumer line (C++).
+        uint32_t tail; // bytes ever released back to the producer
+        uint32_t read; // bytes ever handed to the app (>= tail)
+        uint32_t muted[8]; // one bit per event opcode the app unsubscribed from
+        uint32_t consumer_pad[6];
+    };
+    static_assert(sizeof(EventRing) == 128, "app.js indexes EventRing as a Uint32Array");
+
+    // Accessors for JS. webcc_event_offset_ptr() is the EventRing.
     extern "C" uint8_t *webcc_event_buffer_ptr();
     extern "C" uint32_t *webcc_event_offset_ptr();
     extern "C" uint32_t webcc_event_buffer_capacity();
+    // A block for an out-of-band payload, or 0 when out of memory.
+    extern "C" void *webcc_event_alloc(uint32_t size);
+
+    struct EventBufferStats
+    {
+        uint32_t capacity;   // ring size in bytes
+        uint32_t pending;    // bytes queued and not yet read
+        uint32_t high_water; // most bytes ever queued at once
+        uint32_t dropped;    // events JS discarded because the ring was full
+    };
 
     // C++ API
+    // Drops every queued event.
     void reset_event_buffer();
     const uint8_t *event_buffer_data();
-    uint32_t event_buffer_size();
+    uint32_t event_buffer_size(); // bytes queued and not yet read
+    EventBufferStats event_buffer_stats();
+    // Subscriptions. Every event is delivered until the app unsubscribes from
+    // it; the push_event_* helpers in app.js test `muted` before encoding
+    // anything. Events queued before unsubscribing are still delivered. The
+    // generated <ns>::subscribe(mask) / unsubscribe(mask) wrap these.
+    void subscribe_event(uint8_t opcode);
+    void unsubscribe_event(uint8_t opcode);
+    bool event_subscribed(uint8_t opcode);
+    // Keeps an out-of-band payload of the current event (the data() of one of
+    // its strings) past the next poll. The app then owns it and releases it
+    // with webcc::free(). False if `data` is not one: shorter strings live in
+    // the ring.
+    bool adopt_event_payload(const void *data);
+    // The next event, if any. Its data stays valid until the next call, which
+    // hands the space back to the producer.
     bool next_event(uint8_t& opcode, const uint8_t** data_ptr, uint32_t& data_len);
 
 }
@@ -0,0 +1,25 @@
+#include "webcc/core/frame_arena.h"
+
+namespace webcc
+{
+    // Exported for the JS runtime, which calls it after the main-loop callback
+    // (and after each discrete update) returns. Every frame_scope of the frame
+    // has closed by then, so nothing of the frame's still holds arena memory.
+    extern "C" uint32_t webcc_frame_end()
+    {
+        detail::g_frame_arena.reset();
+
+        HeapStats &st = detail::g_heap_stats;
+        uint32_t allocs = st.frame_allocs;
+        st.frame_allocs = 0;
+        if (!st.frame_alloc_budget || allocs <= st.frame_alloc_budget)
+            return 0;
+        st.frames_over_budget++;
+        if (detail::g_frame_budget_hook)
+        {
+            detail::g_frame_budget_hook(allocs);
+            return 0;
+        }
+        return allocs;
+    }
+}
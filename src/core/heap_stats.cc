@@ -0,0 +1,15 @@
+#include "webcc/core/allocator.h"
+
+// app.js reads webcc::HeapStats at these offsets for webcc_heap().
+static_assert(offsetof(webcc::HeapStats, allocs) == 0);
+static_assert(offsetof(webcc::HeapStats, frees) == 8);
+static_assert(offsetof(webcc::HeapStats, live_bytes) == 16);
+static_assert(offsetof(webcc::HeapStats, grows) == 44);
+static_assert(offsetof(webcc::HeapStats, frames_over_budget) == 60);
+static_assert(offsetof(webcc::HeapStats, size_classes) == 64);
+
+// The heap counters, refreshed, for the browser console.
+extern "C" const webcc::HeapStats *webcc_heap_stats_ptr()
+{
+    return &webcc::heap_stats();
+}
@@ -8,9 +8,69 @@
 #include <stdint.h>
 #include "webcc/core/allocator.h"
 
+// With -mbulk-memory (always on, see compile_wasm) memcpy/memmove/memset
+// lower to single memory.copy / memory.fill instructions. With -msimd128
+// (the default; --no-simd builds the scalar fallback) strlen and memchr scan
+// 16 bytes per step.
+
+#if defined(__wasm_simd128__)
+namespace
+{
+    typedef signed char i8x16 __attribute__((__vector_size__(16), __aligned__(16), __may_alias__));
+
+    // Bit i is set where byte i of the aligned 16-byte block at `p` equals `c`.
+    // An aligned load never crosses a page, so reading past the end of the
+    // string (but not past its block) cannot trap.
+    inline uint32_t match_mask(const char *p, signed char c)
+    {
+        i8x16 needle = {c, c, c, c, c, c, c, c, c, c, c, c, c, c, c, c};
+        return __builtin_wasm_bitmask_i8x16(*(const i8x16 *)p == needle);
+    }
+} // namespace
+#endif
+
 extern "C"
 {
 
+#if defined(__wasm_simd128__)
+    size_t strlen(const char *s)
+    {
+        // The first block starts before `s`; drop the bits of those bytes.
+        uintptr_t off = (uintptr_t)s & 15;
+        const char *p = s - off;
+        uint32_t mask = match_mask(p, 0) >> off << off;
+        while (!mask)
+        {
+            p += 16;
+            mask = match_mask(p, 0);
+        }
+        return (size_t)(p + __builtin_ctz(mask) - s);
+    }
+
+    void *memchr(const void *src, int c, size_t n)
+    {
+        if (!n)
+            return nullptr;
+        const char *s = static_cast<const char *>(src);
+        uintptr_t off = (uintptr_t)s & 15;
+        const char *p = s - off;
+        uint32_t mask = match_mask(p, (signed char)c) >> off << off;
+        for (;;)
+        {
+            // Offsets are checked against n rather than s + n, which may wrap
+            // for an "unbounded" n.
+            if (mask)
+            {
+                size_t i = (size_t)(p - s) + __builtin_ctz(mask);
+                return i < n ? (void *)(s + i) : nullptr;
+            }
+            p += 16;
+            if ((size_t)(p - s) >= n)
+                return nullptr;
+            mask = match_mask(p, (signed char)c);
+        }
+    }
+#else
     size_t strlen(const char *s)
     {
         const char *p = s;
@@ -19,6 +79,34 @@ extern "C"
         return p - s;
     }
 
+    void *memchr(const void *src, int c, size_t n)
+    {
+        const uint8_t *s = static_cast<const uint8_t *>(src);
+        for (; n; --n, ++s)
+            if (*s == static_cast<uint8_t>(c))
+                return (void *)s;
+        return nullptr;
+    }
+#endif
+
+#if defined(__wasm_bulk_memory__)
+    // Each builtin becomes one instruction here, never a call back into
+    // these functions.
+    void *memcpy(void *dest, const void *src, size_t n)
+    {
+        return __builtin_memcpy(dest, src, n);
+    }
+
+    void *memset(void *dest, int c, size_t n)
+    {
+        return __builtin_memset(dest, c, n);
+    }
+
+    void *memmove(void *dest, const void *src, size_t n)
+    {
+        return __builtin_memmove(dest, src, n);
+    }
+#else
     void *memcpy(void *dest, const void *src, size_t n)
     {
         uint8_t *d = static_cast<uint8_t *>(dest);
@@ -54,6 +142,7 @@ extern "C"
         }
         return dest;
     }
+#endif
 }
 
 // Global C++ allocation operators must be outside extern "C" 
@@ -0,0 +1,252 @@
+#include "webcc/core/stats.h"
+#include "webcc/core/wire.h"
+
+namespace webcc::stats
+{
+    // app.js reads Totals by offset (JS_STATS in js_templates.h).
+    static_assert(sizeof(Counter) == 16);
+    static_assert(offsetof(Totals, sent) == 0);
+    static_assert(offsetof(Counters, all) == 4096);
+    static_assert(offsetof(Totals, decode_ms) == 4112);
+    static_assert(offsetof(Totals, decode_max_ms) == 4120);
+    static_assert(offsetof(Totals, requests) == 4128);
+    static_assert(offsetof(Totals, flushes) == 4144);
+
+    namespace
+    {
+        FlushStats g_pending;
+        FlushStats g_last;
+        Totals g_totals;
+        FlushReason g_reason = FlushReason::Explicit;
+        void (*g_hook)(const FlushStats &) = nullptr;
+#ifdef WEBCC_STATS
+        EventLatency g_latency[MAX_EVENT_TYPES];
+        // Events handed out since the last flush, for its latency.
+        struct Waiting
+        {
+            uint8_t opcode;
+            uint32_t stamp_us;
+        };
+        Waiting g_waiting[256];
+        uint32_t g_waiting_count = 0;
+#endif
+
+        void clear(Counters &c)
+        {
+            __builtin_memset(&c, 0, sizeof(c));
+        }
+    }
+
+    // 0..7 exactly, then four buckets per power of two.
+    static int latency_bucket(uint32_t us)
+    {
+        if (us < 8)
+            return (int)us;
+        int e = 31 - __builtin_clz(us);
+        return 8 + (e - 3) * 4 + (int)((us >> (e - 2)) & 3);
+    }
+
+    static uint32_t latency_bucket_max(int b)
+    {
+        if (b < 8)
+            return (uint32_t)b;
+        int e = 3 + (b - 8) / 4;
+        uint64_t top = (uint64_t)(5 + (b - 8) % 4) << (e - 2);
+        return (uint32_t)(top - 1 > 0xFFFFFFFFu ? 0xFFFFFFFFu : top - 1);
+    }
+
+    uint32_t LatencyHistogram::percentile(double p) const
+    {
+        if (samples == 0)
+            return 0;
+        uint64_t rank = (uint64_t)(p * samples + 0.999999);
+        if (rank < 1)
+            rank = 1;
+        uint64_t seen = 0;
+        for (int b = 0; b < BUCKETS; ++b)
+        {
+            seen += counts[b];
+            if (seen >= rank)
+            {
+                uint32_t hi = latency_bucket_max(b);
+                return hi < max_us ? hi : max_us;
+            }
+        }
+        return max_us;
+    }
+
+    const FlushStats &pending() { return g_pending; }
+    const FlushStats &last_flush() { return g_last; }
+    const Totals &totals() { return g_totals; }
+
+    void reset()
+    {
+        clear(g_pending.sent);
+        g_pending.decode_ms = 0;
+        g_last = g_pending;
+        __builtin_memset(&g_totals, 0, sizeof(g_totals));
+#ifdef WEBCC_STATS
+        __builtin_memset(g_latency, 0, sizeof(g_latency));
+        g_waiting_count = 0;
+#endif
+    }
+
+    void set_flush_hook(void (*hook)(const FlushStats &))
+    {
+        g_hook = hook;
+    }
+
+} // namespace webcc::stats
+
+#ifdef WEBCC_STATS
+
+#ifdef __wasm__
+extern "C" void webcc_stats_print();
+#else
+extern "C" void webcc_stats_print() {}
+#endif
+
+#ifdef __wasm__
+extern "C" uint32_t webcc_stats_now_us();
+#else
+// Tests define their own clock.
+extern "C" __attribute__((weak)) uint32_t webcc_stats_now_us() { return 0; }
+#endif
+
+namespace webcc::stats
+{
+    void print() { webcc_stats_print(); }
+
+    const EventLatency &event_latency(uint8_t opcode)
+    {
+        static const EventLatency none = {};
+        return opcode < MAX_EVENT_TYPES ? g_latency[opcode] : none;
+    }
+}
+
+namespace webcc::detail
+{
+    using namespace webcc::stats;
+
+    static void count(uint8_t op, size_t bytes)
+    {
+        Counter &c = g_pending.sent.ops[op];
+        c.commands++;
+        c.bytes += bytes;
+        g_pending.sent.all.commands++;
+        g_pending.sent.all.bytes += bytes;
+    }
+
+    static void record(LatencyHistogram &h, uint32_t us)
+    {
+        h.counts[latency_bucket(us)]++;
+        h.samples++;
+        if (us > h.max_us)
+            h.max_us = us;
+    }
+
+    // [begin, end) is exactly one command, as written by a generated wrapper
+    // or a built-in. In the compact format it may open with the BIND it needed.
+    void stats_command(const uint8_t *begin, const uint8_t *end)
+    {
+        if (begin == end)
+            return;
+        if constexpr (WIRE_VERSION >= 2)
+        {
+            if (begin[0] == OP_BIND && end - begin > (ptrdiff_t)BIND_SIZE)
+            {
+                count(OP_BIND, BIND_SIZE);
+                begin += BIND_SIZE;
+            }
+        }
+        // The opcode's low byte comes first in both formats.
+        count(begin[0], (size_t)(end - begin));
+    }
+
+    void stats_request(FlushReason reason)
+    {
+        g_reason = reason;
+    }
+
+    FlushReason stats_take_reason()
+    {
+        FlushReason reason = g_reason;
+        g_reason = FlushReason::Explicit;
+        g_totals.requests[(int)reason]++;
+        return reason;
+    }
+
+    void stats_flushed(FlushReason reason)
+    {
+        g_pending.reason = reason;
+        for (int op = 0; op < 256; ++op)
+        {
+            g_totals.sent.ops[op].commands += g_pending.sent.ops[op].commands;
+            g_totals.sent.ops[op].bytes += g_pending.sent.ops[op].bytes;
+        }
+        g_totals.sent.all.commands += g_pending.sent.all.commands;
+        g_totals.sent.all.bytes += g_pending.sent.all.bytes;
+        g_totals.decode_ms += g_pending.decode_ms;
+        if (g_pending.decode_ms > g_totals.decode_max_ms)
+            g_totals.decode_max_ms = g_pending.decode_ms;
+        g_totals.flushes[(int)reason]++;
+
+        if (g_waiting_count)
+        {
+            uint32_t now = webcc_stats_now_us();
+            for (uint32_t i = 0; i < g_waiting_count; ++i)
+                record(g_latency[g_waiting[i].opcode].flush, now - g_waiting[i].stamp_us);
+            g_waiting_count = 0;
+        }
+
+        g_last = g_pending;
+        clear(g_pending.sent);
+        g_pending.decode_ms = 0;
+        if (g_hook)
+            g_hook(g_last);
+    }
+
+    // Stamps are u32 microseconds that wrap every 71 minutes; the difference
+    // is right as long as an event waits less than that.
+    void stats_event(uint8_t opcode, uint32_t stamp_us)
+    {
+        if (opcode >= MAX_EVENT_TYPES)
+            return;
+        record(g_latency[opcode].drain, webcc_stats_now_us() - stamp_us);
+        if (g_waiting_count < sizeof(g_waiting) / sizeof(g_waiting[0]))
+            g_waiting[g_waiting_count++] = {opcode, stamp_us};
+    }
+
+    // CommandBuffer::reset() dropped the pending commands unsent.
+    void stats_discarded()
+    {
+        clear(g_pending.sent);
+    }
+}
+
+// Exported only by the instrumented build (see compile_wasm).
+extern "C" webcc::stats::Totals *webcc_stats_ptr()
+{
+    return &webcc::stats::g_totals;
+}
+
+// app.js reports how long it took to decode the batch it is flushing.
+extern "C" void webcc_stats_decoded(double ms)
+{
+    webcc::stats::g_pending.decode_ms = ms;
+}
+
+#else
+
+namespace webcc::stats
+{
+    void print() {}
+
+    const EventLatency &event_latency(uint8_t)
+    {
+        static const EventLatency none = {};
+        return none;
+    }
+}
+
+#endif
@@ -0,0 +1,130 @@
+// Tiny zero-dependency microbenchmark framework for WebCC, the timing
+// counterpart of ../framework.h.
+//
+// Usage:
+//   BENCH(my_bench, 1000) {            // 1000 operations per repetition
+//       for (int i = 0; i < 1000; ++i)
+//           webcc_bench::keep(do_something(i));
+//   }
+//
+// Benchmarks self-register at static-init time. The `bench` binary
+// (bench_main.cc) runs each one `warmup` times untimed, then `reps` times
+// timed, and reports the median and p99 repetition as ns per operation. Any
+// state a benchmark needs is set up in its body; keep that cheap next to the
+// measured work, or do it once in a static.
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace webcc_bench
+{
+    struct Bench
+    {
+        const char *name;
+        uint64_t ops; // operations per repetition
+        void (*fn)();
+    };
+
+    inline std::vector<Bench> &registry()
+    {
+        static std::vector<Bench> r;
+        return r;
+    }
+
+    inline int register_bench(const char *name, uint64_t ops, void (*fn)())
+    {
+        registry().push_back({name, ops, fn});
+        return 0;
+    }
+
+    // Stops the optimizer from dropping a computed value (or the work that
+    // produced it) without adding a store to the measured loop.
+    template <typename T>
+    inline void keep(const T &value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    // Makes the compiler assume memory changed, e.g. after filling a buffer.
+    inline void clobber()
+    {
+        asm volatile("" : : : "memory");
+    }
+
+    struct Options
+    {
+        int warmup = 3;
+        int reps = 31;
+        const char *filter = nullptr; // substring of the benchmark name
+        bool json = false;
+    };
+
+    struct Result
+    {
+        double median_ns; // per operation
+        double p99_ns;
+        double min_ns;
+    };
+
+    inline Result run_one(const Bench &b, const Options &opt)
+    {
+        using clock = std::chrono::steady_clock;
+        for (int i = 0; i < opt.warmup; ++i)
+            b.fn();
+        std::vector<double> ns(opt.reps);
+        for (int i = 0; i < opt.reps; ++i)
+        {
+            auto t0 = clock::now();
+            b.fn();
+            auto t1 = clock::now();
+            ns[i] = std::chrono::duration<double, std::nano>(t1 - t0).count() / (double)b.ops;
+        }
+        std::sort(ns.begin(), ns.end());
+        // Nearest-rank percentiles; with fewer than 100 reps p99 is the max.
+        auto rank = [&](double p) { return ns[std::min(ns.size() - 1, (size_t)(p * ns.size()))]; };
+        return {rank(0.5), rank(0.99), ns.front()};
+    }
+
+    inline int run_all(const Options &opt)
+    {
+        if (opt.reps < 1)
+            return 2;
+        if (opt.json)
+            std::printf("[\n");
+        else
+            std::printf("%-32s %10s %12s %12s %12s\n", "benchmark", "ops/rep", "median ns/op", "p99 ns/op", "Mops/s");
+        bool first = true;
+        for (const Bench &b : registry())
+        {
+            if (opt.filter && !std::strstr(b.name, opt.filter))
+                continue;
+            Result r = run_one(b, opt);
+            double mops = r.median_ns > 0 ? 1e3 / r.median_ns : 0;
+            if (opt.json)
+                std::printf("%s  {\"name\": \"%s\", \"ops\": %llu, \"median_ns\": %.3f, \"p99_ns\": %.3f, \"min_ns\": %.3f, \"mops_per_sec\": %.3f}",
+                            first ? "" : ",\n", b.name, (unsigned long long)b.ops, r.median_ns, r.p99_ns, r.min_ns, mops);
+            else
+                std::printf("%-32s %10llu %12.2f %12.2f %12.2f\n", b.name, (unsigned long long)b.ops, r.median_ns, r.p99_ns, mops);
+            std::fflush(stdout);
+            first = false;
+        }
+        if (opt.json)
+            std::printf("\n]\n");
+        return 0;
+    }
+} // namespace webcc_bench
+
+#define WEBCC_BENCH_CAT_(a, b) a##b
+#define WEBCC_BENCH_CAT(a, b) WEBCC_BENCH_CAT_(a, b)
+
+#define BENCH(name, ops)                                                          \
+    static void name();                                                           \
+    static int WEBCC_BENCH_CAT(name, _reg) =                                      \
+        ::webcc_bench::register_bench(#name, (ops), name);                        \
+    static void name()
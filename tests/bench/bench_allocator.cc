@@ -0,0 +1,137 @@
+// Allocator churn patterns (include/webcc/core/allocator.h, host arena).
+// Each repetition frees everything it takes, so the heap is back where it
+// started. (detail::heap_reset() would also drop blocks other benchmarks
+// keep in statics.)
+
+#include "webcc/core/allocator.h"
+#include "webcc/core/object_pool.h"
+#include "bench.h"
+
+namespace
+{
+    // Deterministic sizes and slots, so every run churns the same way.
+    struct Lcg
+    {
+        uint32_t s = 12345;
+        uint32_t next() { return s = s * 1664525u + 1013904223u; }
+    };
+
+    constexpr int N = 4096;
+    void *g_ptrs[N];
+}
+
+// Allocate and immediately free: the cheapest path, reclaim into the top.
+BENCH(alloc_free_64, N)
+{
+    for (int i = 0; i < N; ++i)
+    {
+        void *p = webcc::malloc(64);
+        webcc_bench::keep(p);
+        webcc::free(p);
+    }
+}
+
+// A frame's worth of mixed-size temporaries, released in allocation order.
+BENCH(alloc_mixed_fifo, N)
+{
+    for (int i = 0; i < N; ++i)
+        g_ptrs[i] = webcc::malloc(16 << (i % 6));
+    for (int i = 0; i < N; ++i)
+        webcc::free(g_ptrs[i]);
+}
+
+// Same, released newest first.
+BENCH(alloc_mixed_lifo, N)
+{
+    for (int i = 0; i < N; ++i)
+        g_ptrs[i] = webcc::malloc(16 << (i % 6));
+    for (int i = N - 1; i >= 0; --i)
+        webcc::free(g_ptrs[i]);
+}
+
+// Long-running churn: 512 live blocks, each step frees one at random and
+// allocates 8..1024 bytes in its place. This is what fragments a heap.
+BENCH(alloc_random_churn, 16 * N)
+{
+    constexpr int LIVE = 512;
+    Lcg rng;
+    for (int i = 0; i < LIVE; ++i)
+        g_ptrs[i] = webcc::malloc(8 + rng.next() % 1017);
+    for (int i = 0; i < 16 * N; ++i)
+    {
+        uint32_t slot = rng.next() % LIVE;
+        webcc::free(g_ptrs[slot]);
+        g_ptrs[slot] = webcc::malloc(8 + (rng.next() >> 8) % 1017);
+    }
+    for (int i = 0; i < LIVE; ++i)
+        webcc::free(g_ptrs[i]);
+}
+
+// A heap riddled with small holes (every other 16-byte block freed), then a
+// frame's worth of 256-byte temporaries. None of the holes can serve them; a
+// free-list walk visits every hole before bumping, a size-class lookup does not.
+BENCH(alloc_past_small_holes, N / 4)
+{
+    constexpr int HOLES = N / 4;
+    for (int i = 0; i < 2 * HOLES; ++i)
+        g_ptrs[i] = webcc::malloc(16);
+    for (int i = 0; i < 2 * HOLES; i += 2)
+        webcc::free(g_ptrs[i]);
+    for (int i = 2 * HOLES; i < 2 * HOLES + N / 4; ++i)
+        g_ptrs[i] = webcc::malloc(256);
+    for (int i = 2 * HOLES; i < 2 * HOLES + N / 4; ++i)
+        webcc::free(g_ptrs[i]);
+    for (int i = 1; i < 2 * HOLES; i += 2)
+        webcc::free(g_ptrs[i]);
+}
+
+// Buffers growing side by side, the way vectors and strings do.
+BENCH(realloc_grow_interleaved, 4 * 12)
+{
+    void *bufs[4] = {};
+    for (size_t size = 16; size <= (16u << 11); size *= 2)
+        for (void *&b : bufs)
+            b = webcc::realloc(b, size);
+    for (void *b : bufs)
+        webcc::free(b);
+}
+
+// Same-sized nodes churned through the general heap and through a pool:
+// 512 live 48-byte nodes, one replaced per step.
+struct Node
+{
+    Node *parent, *first_child, *next_sibling;
+    float x, y, w, h;
+};
+
+BENCH(node_churn_malloc, 16 * N)
+{
+    constexpr int LIVE = 512;
+    Lcg rng;
+    for (int i = 0; i < LIVE; ++i)
+        g_ptrs[i] = webcc::malloc(sizeof(Node));
+    for (int i = 0; i < 16 * N; ++i)
+    {
+        uint32_t slot = rng.next() % LIVE;
+        webcc::free(g_ptrs[slot]);
+        g_ptrs[slot] = webcc::malloc(sizeof(Node));
+    }
+    for (int i = 0; i < LIVE; ++i)
+        webcc::free(g_ptrs[i]);
+}
+
+BENCH(node_churn_pool, 16 * N)
+{
+    constexpr int LIVE = 512;
+    static webcc::object_pool<Node> pool;
+    Lcg rng;
+    for (int i = 0; i < LIVE; ++i)
+        g_ptrs[i] = pool.create();
+    for (int i = 0; i < 16 * N; ++i)
+    {
+        uint32_t slot = rng.next() % LIVE;
+        pool.destroy((Node *)g_ptrs[slot]);
+        g_ptrs[slot] = pool.create();
+    }
+    pool.clear();
+}
@@ -0,0 +1,52 @@
+// Command encoding throughput (src/core/command_buffer.cc). The buffer is
+// reset before each repetition; when it fills, the usual overflow flush runs
+// against the host stub of webcc_js_flush.
+
+#include "command_buffer.h"
+#include "bench.h"
+
+using webcc::CommandBuffer;
+using webcc::CommandCursor;
+
+namespace
+{
+    constexpr int N = 16384;
+}
+
+// What a generated wrapper such as canvas::fill_rect() does per call.
+BENCH(cmd_fill_rect, N)
+{
+    CommandBuffer::reset();
+    for (int i = 0; i < N; ++i)
+    {
+        if (CommandCursor c = CommandBuffer::reserve(48))
+        {
+            c.u32(37);
+            c.i32(1);
+            c.f64(i);
+            c.f64(i * 0.5);
+            c.f64(10);
+            c.f64(10);
+            CommandBuffer::commit(c);
+        }
+    }
+    webcc_bench::clobber();
+}
+
+// One reservation per value: the old push_* style.
+BENCH(cmd_push_u32, N)
+{
+    CommandBuffer::reset();
+    for (int i = 0; i < N; ++i)
+        CommandBuffer::push_u32((uint32_t)i);
+    webcc_bench::clobber();
+}
+
+BENCH(cmd_push_string_16, N)
+{
+    static const char text[] = "hello, command!!";
+    CommandBuffer::reset();
+    for (int i = 0; i < N; ++i)
+        CommandBuffer::push_string(text, 16);
+    webcc_bench::clobber();
+}
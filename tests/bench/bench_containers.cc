@@ -0,0 +1,81 @@
+// webcc::unordered_map insert, lookup and erase (include/webcc/core/unordered_map.h),
+// and webcc::vector insertion (include/webcc/core/vector.h).
+
+#include "webcc/core/string.h"
+#include "webcc/core/unordered_map.h"
+#include "webcc/core/vector.h"
+#include "bench.h"
+
+namespace
+{
+    constexpr int N = 8192;
+
+    // Keys spread the way handles and ids do: dense-ish, not sequential.
+    int32_t key(int i) { return (int32_t)((uint32_t)i * 2654435761u >> 8); }
+
+    // Built on first use and kept for the whole run.
+    webcc::unordered_map<int32_t, int32_t> &filled()
+    {
+        static webcc::unordered_map<int32_t, int32_t> m;
+        if (m.empty())
+            for (int i = 0; i < N; ++i)
+                m[key(i)] = i;
+        return m;
+    }
+}
+
+BENCH(map_insert, N)
+{
+    webcc::unordered_map<int32_t, int32_t> m;
+    for (int i = 0; i < N; ++i)
+        m[key(i)] = i;
+    webcc_bench::keep(m.size());
+}
+
+BENCH(map_lookup_hit, N)
+{
+    auto &m = filled();
+    int32_t sum = 0;
+    for (int i = 0; i < N; ++i)
+        sum += m[key(i)];
+    webcc_bench::keep(sum);
+}
+
+BENCH(map_lookup_miss, N)
+{
+    auto &m = filled();
+    size_t hits = 0;
+    for (int i = 0; i < N; ++i)
+        hits += m.contains(key(i + N));
+    webcc_bench::keep(hits);
+}
+
+// Fill then empty, so the erase half runs over a table full of tombstones.
+BENCH(map_insert_erase, 2 * N)
+{
+    webcc::unordered_map<int32_t, int32_t> m;
+    for (int i = 0; i < N; ++i)
+        m[key(i)] = i;
+    for (int i = 0; i < N; ++i)
+        m.erase(key(i));
+    webcc_bench::keep(m.size());
+}
+
+BENCH(map_string_keys, N)
+{
+    static const char *names[] = {"click", "keydown", "pointermove", "resize", "wheel", "focus", "blur", "input"};
+    webcc::unordered_map<webcc::string, int32_t> m;
+    for (int i = 0; i < N; ++i)
+        m[webcc::string(names[i & 7])] += 1;
+    webcc_bench::keep(m.size());
+}
+
+// Front insertion shifts the whole vector each time; strings are relocatable,
+// so that is one memmove.
+BENCH(vector_string_insert_front, 512)
+{
+    webcc::vector<webcc::string> v;
+    for (int i = 0; i < 512; ++i)
+        v.insert(0, webcc::string("label"));
+    webcc_bench::keep(v.size());
+}
@@ -0,0 +1,29 @@
+#include "bench.h"
+
+#include <cstdlib>
+
+// ./bench [--reps N] [--warmup N] [--filter substring] [--json]
+int main(int argc, char **argv)
+{
+    webcc_bench::Options opt;
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *a = argv[i];
+        if (!std::strcmp(a, "--reps") && i + 1 < argc)
+            opt.reps = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--warmup") && i + 1 < argc)
+            opt.warmup = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--filter") && i + 1 < argc)
+            opt.filter = argv[++i];
+        else if (!std::strcmp(a, "--json"))
+            opt.json = true;
+        else
+        {
+            std::fprintf(stderr, "usage: %s [--reps N] [--warmup N] [--filter substring] [--json]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (!opt.json)
+        std::printf("WebCC benchmarks (%d reps, %d warmup)\n\n", opt.reps, opt.warmup);
+    return webcc_bench::run_all(opt);
+}
@@ -0,0 +1,63 @@
+// webcc::string concatenation and the formatters (include/webcc/core/string.h,
+// include/webcc/core/format.h).
+
+#include "webcc/core/string.h"
+#include "bench.h"
+
+namespace
+{
+    constexpr int N = 4096;
+}
+
+// Appending short pieces to one growing string.
+BENCH(string_append, N)
+{
+    webcc::string s;
+    for (int i = 0; i < N; ++i)
+        s += "item ";
+    webcc_bench::keep(s.length());
+}
+
+// Building a label from temporaries, e.g. "score: " + n + " pts".
+BENCH(string_concat_temporaries, N)
+{
+    size_t total = 0;
+    for (int i = 0; i < N; ++i)
+    {
+        webcc::string label = webcc::string("score: ") + i + " pts";
+        total += label.length();
+    }
+    webcc_bench::keep(total);
+}
+
+// One short line per operation into a reused stack buffer.
+BENCH(format_stack_line, N)
+{
+    webcc::formatter<128> f;
+    size_t total = 0;
+    for (int i = 0; i < N; ++i)
+    {
+        f.clear();
+        f << "x=" << i << " y=" << -i << " color=" << webcc::hex(0xff8800u + i) << " a=" << 0.5f;
+        total += f.length();
+    }
+    webcc_bench::keep(total);
+}
+
+// A long log assembled piece by piece on the heap.
+BENCH(format_dynamic_log, N)
+{
+    webcc::dynamic_formatter f;
+    for (int i = 0; i < N; ++i)
+        f << "frame " << i << ": " << (unsigned)(i * 16) << " bytes\n";
+    webcc_bench::keep(f.length());
+}
+
+// Spills from its stack buffer partway through.
+BENCH(format_hybrid_spill, N)
+{
+    webcc::hybrid_formatter<1024> f;
+    for (int i = 0; i < N; ++i)
+        f << "entry " << i << " " << 1.25 << "\n";
+    webcc_bench::keep(f.length());
+}
@@ -4,6 +4,7 @@
 #   ./tests/run.sh            Build & run all tests (C++ units + codegen snapshots + JS validation)
 #   ./tests/run.sh --update   Regenerate golden snapshots, then run
 #   ./tests/run.sh --skip-js  Skip the Node JS-validation layer (no webcc build / node needed)
+#   ./tests/run.sh --bench    Build & run the microbenchmarks (tests/bench) instead of the tests
 #
 # Zero extra dependencies: uses the same clang++ the toolchain requires, plus
 # node (already needed to serve examples) for the JS syntax checks.
@@ -15,18 +16,38 @@ mkdir -p "$BUILD"
 
 UPDATE=0
 SKIP_JS=0
+BENCH=0
 for arg in "$@"; do
     case "$arg" in
         --update) UPDATE=1 ;;
         --skip-js) SKIP_JS=1 ;;
+        --bench) BENCH=1 ;;
         *) echo "Unknown option: $arg"; exit 2 ;;
     esac
 done
 
 CXX="${CXX:-clang++}"
 
+if [ "$BENCH" = "1" ]; then
+    echo "[bench] Compiling benchmarks..."
+    # Optimized and uninstrumented, like a release app's runtime.
+    "$CXX" -std=c++20 -O2 -DNDEBUG \
+        -I "$ROOT/src/core" -I "$ROOT/include" \
+        "$ROOT/tests/bench/bench_main.cc" \
+        "$ROOT/tests/bench/bench_allocator.cc" \
+        "$ROOT/tests/bench/bench_command_buffer.cc" \
+        "$ROOT/tests/bench/bench_containers.cc" \
+        "$ROOT/tests/bench/bench_string.cc" \
+        "$ROOT/src/core/command_buffer.cc" \
+        -o "$BUILD/bench"
+    echo "[bench] Running..."
+    exec "$BUILD/bench"
+fi
+
 echo "[tests] Compiling C++ test suite..."
-"$CXX" -std=c++20 -O1 -g \
+# WEBCC_STATS: the runtime is built instrumented (webcc --stats) so the
+# counting hooks are covered too; they never change the encoded bytes.
+"$CXX" -std=c++20 -O1 -g -DWEBCC_STATS \
     -I "$ROOT/src/cli" -I "$ROOT/src/core" -I "$ROOT/include" \
     -DWEBCC_SCHEMA_DEF="\"$ROOT/schema.def\"" \
     -DWEBCC_SNAPSHOT_DIR="\"$ROOT/tests/snapshots\"" \
@@ -36,10 +57,17 @@ echo "[tests] Compiling C++ test suite..."
     "$ROOT/tests/test_codegen.cc" \
     "$ROOT/tests/test_allocator.cc" \
     "$ROOT/tests/test_containers.cc" \
+    "$ROOT/tests/test_disasm.cc" \
+    "$ROOT/tests/test_event_buffer.cc" \
     "$ROOT/src/cli/schema.cc" \
     "$ROOT/src/cli/utils.cc" \
     "$ROOT/src/cli/generators.cc" \
+    "$ROOT/src/cli/disasm.cc" \
     "$ROOT/src/core/command_buffer.cc" \
+    "$ROOT/src/core/event_buffer.cc" \
+    "$ROOT/src/core/frame_arena.cc" \
+    "$ROOT/src/core/heap_stats.cc" \
+    "$ROOT/src/core/stats.cc" \
     -o "$BUILD/tests"
 
 echo "[tests] Running C++ test suite..."
@@ -45,12 +45,12 @@ const run = async () => {
         const bytes = await response.arrayBuffer();
         mod = await WebAssembly.instantiate(bytes, imports);
     }
-    const { memory, main, __indirect_function_table: table, webcc_event_buffer_ptr, webcc_event_offset_ptr, webcc_event_buffer_capacity, webcc_scratch_buffer_ptr } = mod.instance.exports;
+    const { memory, main, __indirect_function_table: table, webcc_event_buffer_ptr, webcc_event_offset_ptr, webcc_event_buffer_capacity, webcc_event_alloc, webcc_frame_end, webcc_heap_stats_ptr, webcc_scratch_buffer_ptr } = mod.instance.exports;
 
     const event_buffer_ptr_val = webcc_event_buffer_ptr();
     const event_offset_ptr_val = webcc_event_offset_ptr();
     const scratch_buffer_ptr_val = webcc_scratch_buffer_ptr();
-    let event_offset_view = new Uint32Array(memory.buffer, event_offset_ptr_val, 1);
+    let event_ring = new Uint32Array(memory.buffer, event_offset_ptr_val, 32); // EventRing
     let event_u8 = new Uint8Array(memory.buffer, event_buffer_ptr_val);
     let event_i32 = new Int32Array(memory.buffer, event_buffer_ptr_val);
     let event_f32 = new Float32Array(memory.buffer, event_buffer_ptr_val);
@@ -64,10 +64,33 @@ const run = async () => {
     function _triggerDiscreteUpdate() {
         if (_updateFn && !_updatePending) {
             _updatePending = true;
-            queueMicrotask(() => { _updatePending = false; _updateFn(performance.now()); });
+            queueMicrotask(() => { _updatePending = false; _updateFn(performance.now()); _frameEnd(); });
         }
     }
 
+    function _frameEnd() {
+        const allocs = webcc_frame_end();
+        if (allocs) console.warn(`WebCC: ${allocs} heap allocations in one frame, over the budget`);
+    }
+    function webcc_heap() {
+        const dv = new DataView(memory.buffer, webcc_heap_stats_ptr());
+        const u32 = (off) => dv.getUint32(off, true);
+        const u64 = (off) => u32(off) + u32(off + 4) * 4294967296;
+        const size_classes = {};
+        for (let k = 0; k < 26; k++) {
+            const n = u32(64 + 4 * k);
+            if (n) size_classes[k ? `${2 ** (k + 6)}-${2 ** (k + 7) - 1}` : '<128'] = n;
+        }
+        return {
+            allocs: u64(0), frees: u64(8), live_bytes: u32(16), peak_live_bytes: u32(20),
+            free_blocks: u32(24), free_bytes: u32(28), largest_free: u32(32),
+            heap_bytes: u32(36), committed_bytes: u32(40), grows: u32(44), grown_bytes: u32(48),
+            frame_allocs: u32(52), frame_alloc_budget: u32(56), frames_over_budget: u32(60),
+            size_classes,
+        };
+    }
+    globalThis.webcc_heap = webcc_heap;
+
     const elements = []; elements[0] = document.body;
 
     // Reusable text decoder to avoid garbage collection overhead
@@ -87,9 +110,10 @@ const run = async () => {
             f64 = new Float64Array(memory.buffer);
         }
 
-        let pos = ptr;
-        const end = ptr + size;
+        exec(u8, i32, f32, f64, ptr, ptr + size);
+    }
 
+    function exec(u8, i32, f32, f64, pos, end) {
         // Loop through the buffer
         while (pos < end) {
             if (pos + 4 > end) {
@@ -10,6 +10,7 @@
 #include "generators.h"
 #include "utils.h"
 
+#include <cstdio>
 #include <cstdlib>
 #include <fstream>
 #include <string>
@@ -84,6 +85,41 @@ namespace
         return load_defs(std::string(WEBCC_SCHEMA_DEF));
     }
 
+    // The real schema with the compact (v2) wire options switched on: float32
+    // canvas coordinates and a bind register for 2D contexts.
+    SchemaDefs compact_defs()
+    {
+        std::string path = "/tmp/webcc_test_compact.def";
+        std::ofstream out(path);
+        out << "meta|wire|compact\n"
+               "meta|precision|canvas|float32\n"
+               "meta|bind|CanvasContext2D\n"
+            << read_file(WEBCC_SCHEMA_DEF);
+        out.close();
+        SchemaDefs defs = load_defs(path);
+        std::remove(path.c_str());
+        return defs;
+    }
+
+    // Run emit_headers in a scratch directory (it writes to relative paths) and
+    // return the generated header `include/webcc/<name>`.
+    std::string emit_header_in_temp(const SchemaDefs &defs, const std::string &name)
+    {
+        char cwd[4096];
+        if (!getcwd(cwd, sizeof(cwd)))
+            return "";
+        const char *tmp = "/tmp/webcc_headers_fixture";
+        std::string mk = std::string("mkdir -p ") + tmp;
+        (void)system(mk.c_str());
+        if (chdir(tmp) != 0)
+            return "";
+        emit_headers(defs);
+        std::string header = read_file("include/webcc/" + name);
+        if (chdir(cwd) != 0)
+            ::webcc_test::record_failure("chdir back failed - subsequent tests unsafe");
+        return header;
+    }
+
     // Build the module-"w" marker set (opcode strings) for the given void
     // commands, mirroring what the linker emits when those wrappers are
     // referenced by user code. generate_js_runtime detects void commands from
@@ -172,6 +208,453 @@ TEST(codegen_dom_user_snapshot)
     check_snapshot("app_dom.js", js);
 }
 
+// The reservation emitted for a void command must cover its worst-case encoding
+// from either start offset (mod 8): doubles may need 4 bytes of padding.
+TEST(codegen_encoded_size_covers_worst_case_padding)
+{
+    SchemaDefs defs = real_defs();
+    auto find = [&](const std::string &ns, const std::string &name) -> const SchemaCommand *
+    {
+        for (const auto &c : defs.commands)
+            if (c.ns == ns && c.name == name)
+                return &c;
+        return nullptr;
+    };
+    const SchemaCommand *fill = find("canvas", "FILL_RECT");
+    const SchemaCommand *font = find("canvas", "SET_FONT");
+    CHECK(fill && font);
+    if (!fill || !font)
+        return;
+    // op + handle + 4 doubles: 40 bytes when it starts 8-aligned, 44 otherwise.
+    CHECK_EQ(encoded_size(*fill), (size_t)44);
+    // op + handle + string length prefix; the payload is added at run time.
+    CHECK_EQ(encoded_size(*font), (size_t)12);
+
+    // A double after a string is charged its padding unconditionally.
+    SchemaCommand c;
+    c.params = {{"string", "s", ""}, {"float64", "d", ""}};
+    CHECK_EQ(encoded_size(c), (size_t)20);
+
+    // Compact: no padding, 1-byte opcode.
+    c.compact = true;
+    CHECK_EQ(encoded_size(c), (size_t)13);
+}
+
+// Compact (v2) wire format: byte opcodes, packed narrow ints, float32
+// coordinates, and the context handle dropped in favour of a bind register.
+TEST(codegen_compact_wire_headers)
+{
+    SchemaDefs defs = compact_defs();
+    std::string canvas = emit_header_in_temp(defs, "canvas.h");
+    CHECK(!canvas.empty());
+
+    // fill_rect: opcode (1) + possible BIND (6) + 4 x float32 (16).
+    CHECK(canvas.find("reserve(23);") != std::string::npos);
+    CHECK(canvas.find("_cmd.bind(0, (int32_t)handle);") != std::string::npos);
+    CHECK(canvas.find("_cmd.u8(OP_FILL_RECT);") != std::string::npos);
+    CHECK(canvas.find("_cmd.f32((float)x);") != std::string::npos);
+    // uint8 params take one byte; strings are not padded.
+    CHECK(canvas.find("_cmd.u8(r);") != std::string::npos);
+    CHECK(canvas.find("_cmd.str_packed(font.data(), font.length(), font.ref());") != std::string::npos);
+    CHECK(canvas.find("reserve(11 + font.length());") != std::string::npos);
+    // The C++ API itself is unchanged.
+    CHECK(canvas.find("inline void fill_rect(webcc::CanvasContext2D handle, double x, double y, double w, double h)") != std::string::npos);
+}
+
+TEST(codegen_compact_wire_js)
+{
+    SchemaDefs defs = compact_defs();
+    std::set<std::string> imports = {
+        "webcc_js_flush",
+        "webcc_canvas_create_canvas",
+        "webcc_canvas_get_context_2d",
+    };
+    auto markers = void_markers(defs, {"canvas::fill_rect", "canvas::set_fill_style"});
+    generate_js_runtime(defs, imports, markers, {}, "/tmp");
+    std::string js = read_file("/tmp/app.js");
+
+    CHECK(js.find("const opcode = u8[pos];") != std::string::npos);
+    CHECK(js.find("const handle = bound[0];") != std::string::npos);
+    CHECK(js.find("const x = dv.getFloat32(pos, true); pos += 4;") != std::string::npos);
+    CHECK(js.find("const r = u8[pos]; pos += 1;") != std::string::npos);
+    // The BIND built-in is decoded because a bound command is used.
+    CHECK(js.find("case 254: {") != std::string::npos);
+    CHECK(js.find("f64[pos >> 3]") == std::string::npos);
+}
+
+// Without a bound command in the build, the BIND case is left out.
+TEST(codegen_compact_wire_js_no_bind_when_unused)
+{
+    SchemaDefs defs = compact_defs();
+    std::set<std::string> imports = {"webcc_js_flush", "webcc_dom_get_body"};
+    auto markers = void_markers(defs, {"dom::set_inner_text"});
+    generate_js_runtime(defs, imports, markers, {}, "/tmp");
+    std::string js = read_file("/tmp/app.js");
+
+    CHECK(js.find("const text_len = dv.getUint32(pos, true); pos += 4;") != std::string::npos);
+    CHECK(js.find("case 254: {") == std::string::npos);
+}
+
+// intern() leaves the INTERN built-in's marker (w."255"). Only then does app.js
+// keep the decoded-string table and accept ids in string params.
+TEST(codegen_js_interned_strings_only_when_used)
+{
+    SchemaDefs defs = real_defs();
+    std::set<std::string> imports = {"webcc_js_flush", "webcc_dom_get_body"};
+    auto markers = void_markers(defs, {"dom::set_attribute"});
+
+    generate_js_runtime(defs, imports, markers, {}, "/tmp");
+    std::string plain = read_file("/tmp/app.js");
+    CHECK(plain.find("interned_strings") == std::string::npos);
+
+    markers.insert("255");
+    generate_js_runtime(defs, imports, markers, {}, "/tmp");
+    std::string js = read_file("/tmp/app.js");
+    CHECK(js.find("const interned_strings = [];") != std::string::npos);
+    CHECK(js.find("case 255: {") != std::string::npos);
+    CHECK(js.find("const name = name_len < 0 ? interned_strings[name_len & 0x7FFFFFFF]") != std::string::npos);
+    CHECK(js.find("w: new Proxy(") != std::string::npos);
+}
+
+// The display-list built-ins share one marker (w."253"). Without it flush()
+// runs exec() directly and no recorder is emitted.
+TEST(codegen_js_display_lists_only_when_used)
+{
+    SchemaDefs defs = real_defs();
+    std::set<std::string> imports = {"webcc_js_flush", "webcc_dom_get_body"};
+    auto markers = void_markers(defs, {"dom::set_attribute"});
+
+    generate_js_runtime(defs, imports, markers, {}, "/tmp");
+    std::string plain = read_file("/tmp/app.js");
+    CHECK(plain.find("exec(u8, i32, f32, f64, ptr, ptr + size);") != std::string::npos);
+    CHECK(plain.find("display_lists") == std::string::npos);
+    CHECK(plain.find("rec_id") == std::string::npos);
+
+    markers.insert("253");
+    generate_js_runtime(defs, imports, markers, {}, "/tmp");
+    std::string js = read_file("/tmp/app.js");
+    CHECK(js.find("const display_lists = [];") != std::string::npos);
+    CHECK(js.find("if (rec_id >= 0) rec_chunk(rec_from, ptr + size);") != std::string::npos);
+    CHECK(js.find("case 253: {") != std::string::npos);
+    CHECK(js.find("rec_chunk(rec_from, pos - 4);") != std::string::npos);
+    CHECK(js.find("if (parts) for (const part of parts) exec(...part);") != std::string::npos);
+    CHECK(js.find("case 250: {") != std::string::npos);
+
+    SchemaDefs compact = compact_defs();
+    generate_js_runtime(compact, imports, markers, {}, "/tmp");
+    std::string cjs = read_file("/tmp/app.js");
+    CHECK(cjs.find("exec(u8, dv, ptr, ptr + size);") != std::string::npos);
+    CHECK(cjs.find("rec_chunk(rec_from, pos - 1);") != std::string::npos);
+    CHECK(cjs.find("const parts = display_lists[dv.getInt32(pos, true)]; pos += 4;") != std::string::npos);
+}
+
+// --release: one bounds check per fixed-size command (sized at run time when
+// a double's padding depends on the start offset), no diagnostics.
+TEST(codegen_js_release_merges_bounds_checks)
+{
+    SchemaDefs defs = real_defs();
+    std::set<std::string> imports = {
+        "webcc_js_flush",
+        "webcc_canvas_create_canvas",
+        "webcc_canvas_get_context_2d",
+    };
+    auto markers = void_markers(defs, {"canvas::fill_rect", "canvas::set_font"});
+    generate_js_runtime(defs, imports, markers, {}, "/tmp", JsRuntimeOptions{true});
+    std::string js = read_file("/tmp/app.js");
+
+    // fill_rect: handle + 4 doubles, 36 or 40 bytes after the opcode.
+    CHECK(js.find("if (pos + ((pos & 4) ? 36 : 40) > end) return;") != std::string::npos);
+    CHECK(js.find("pos += pos & 4;") != std::string::npos);
+    // set_font: handle + length prefix, then the string's own bytes.
+    CHECK(js.find("if (pos + 8 > end) return;") != std::string::npos);
+    CHECK(js.find("if (pos + font_bytes > end) return;") != std::string::npos);
+    CHECK(js.find("OOB") == std::string::npos);
+    CHECK(js.find("console.warn('") == std::string::npos);
+    CHECK(js.find("Unknown opcode") == std::string::npos);
+    CHECK(js.find("Unexpected end of buffer") == std::string::npos);
+
+    // The default (debug) build keeps the per-field checks.
+    generate_js_runtime(defs, imports, markers, {}, "/tmp");
+    std::string debug = read_file("/tmp/app.js");
+    CHECK(debug.find("console.error('WebCC: OOB x'); break;") != std::string::npos);
+    CHECK(debug.find("Unknown opcode") != std::string::npos);
+}
+
+// --dispatch=table: a handler per opcode, a dense table, and cached context
+// lookups in the handlers (invalidated by commands that write the map).
+TEST(codegen_js_table_dispatch)
+{
+    SchemaDefs defs = real_defs();
+    std::set<std::string> imports = {
+        "webcc_js_flush",
+        "webcc_canvas_create_canvas",
+        "webcc_canvas_get_context_2d",
+        "webcc_dom_get_body",
+    };
+    auto markers = void_markers(defs, {"canvas::fill_rect", "dom::remove_element"});
+    JsRuntimeOptions options;
+    options.dispatch = JsDispatch::Table;
+    generate_js_runtime(defs, imports, markers, {}, "/tmp", options);
+    std::string js = read_file("/tmp/app.js");
+
+    CHECK(js.find("switch (opcode)") == std::string::npos);
+    CHECK(js.find("pos = ops[i32[pos >> 2]](u8, i32, f32, f64, pos + 4, end);") != std::string::npos);
+    CHECK(js.find("function op_canvas_fill_rect(u8, i32, f32, f64, pos, end) {") != std::string::npos);
+    CHECK(js.find("const ops = new Array(256).fill(op_unknown);") != std::string::npos);
+    CHECK(js.find("] = op_canvas_fill_rect;") != std::string::npos);
+    // Actions run inside a function: no `continue`/`break` at handler level.
+    CHECK(js.find("const ctx = contexts_at(handle); if(!ctx){ console.warn('fill_rect: unknown context', handle); return pos; }") != std::string::npos);
+    CHECK(js.find("{ console.error('WebCC: OOB x'); return end; }") != std::string::npos);
+    // remove_element writes `elements`, so it reads the map directly and
+    // resets the cache.
+    CHECK(js.find("elements_h = -1;") != std::string::npos);
+    CHECK(js.find("function elements_at(h) {") != std::string::npos);
+}
+
+// A table-dispatch handler whose action loops: `continue` inside the loop
+// must not become `return pos`.
+TEST(codegen_js_table_dispatch_keeps_loop_continue)
+{
+    std::string path = "/tmp/webcc_test_loop.def";
+    std::ofstream out(path);
+    out << read_file(WEBCC_SCHEMA_DEF)
+        << "canvas|command|FILL_DOTS|fill_dots|handle(CanvasContext2D):handle int32:n|"
+           "{ const ctx = contexts[handle]; if(!ctx){ continue; } "
+           "for (let i = 0; i < n; i++) { if (i % 2) continue; ctx.fillRect(i, 0, 1, 1); } }\n";
+    out.close();
+    SchemaDefs defs = load_defs(path);
+    std::remove(path.c_str());
+
+    std::set<std::string> imports = {"webcc_js_flush", "webcc_canvas_create_canvas"};
+    auto markers = void_markers(defs, {"canvas::fill_dots", "canvas::fill_rect"});
+    JsRuntimeOptions options;
+    options.dispatch = JsDispatch::Table;
+    generate_js_runtime(defs, imports, markers, {}, "/tmp", options);
+    std::string js = read_file("/tmp/app.js");
+
+    CHECK(js.find("do { { const ctx = contexts_at(handle); if(!ctx){ continue; } "
+                  "for (let i = 0; i < n; i++) { if (i % 2) continue; ctx.fillRect(i, 0, 1, 1); } } } while (false);") != std::string::npos);
+    // Loop-free actions keep the plain rewrite.
+    CHECK(js.find("if(!ctx){ console.warn('fill_rect: unknown context', handle); return pos; }") != std::string::npos);
+}
+
+// --stats: flush() times the decode loop and reports it back, and the
+// console report knows the names of the commands in use.
+TEST(codegen_js_stats)
+{
+    SchemaDefs defs = real_defs();
+    std::set<std::string> imports = {"webcc_js_flush", "webcc_canvas_create_canvas"};
+    auto markers = void_markers(defs, {"canvas::fill_rect"});
+    JsRuntimeOptions options;
+    options.stats = true;
+    generate_js_runtime(defs, imports, markers, {}, "/tmp", options);
+    std::string js = read_file("/tmp/app.js");
+
+    CHECK(js.find("webcc_stats_print: () => webcc_stats()") != std::string::npos);
+    CHECK(js.find(", webcc_stats_ptr, webcc_stats_decoded }") != std::string::npos);
+    CHECK(js.find("webcc_stats_decoded(performance.now() - t0);") != std::string::npos);
+    CHECK(js.find(": \"canvas.fill_rect\",") != std::string::npos);
+    CHECK(js.find("function webcc_stats()") != std::string::npos);
+
+    generate_js_runtime(defs, imports, markers, {}, "/tmp");
+    std::string plain = read_file("/tmp/app.js");
+    CHECK(plain.find("webcc_stats") == std::string::npos);
+    CHECK(plain.find("performance.now() - t0") == std::string::npos);
+}
+
+// --capture: flushes and return-value calls are logged before they run, with
+// the positions of string pointers so disasm can show the text.
+TEST(codegen_js_capture)
+{
+    SchemaDefs defs = real_defs();
+    std::set<std::string> imports = {"webcc_js_flush", "webcc_canvas_create_canvas"};
+    auto markers = void_markers(defs, {"canvas::fill_rect"});
+    JsRuntimeOptions options;
+    options.capture = true;
+    generate_js_runtime(defs, imports, markers, {}, "/tmp", options);
+    std::string js = read_file("/tmp/app.js");
+
+    CHECK(js.find("capture_call(\"webcc_canvas_create_canvas\", [dom_id_ptr, dom_id_len, width, height], [0]);") != std::string::npos);
+    CHECK(js.find("capture_flush(ptr, size);") != std::string::npos);
+    CHECK(js.find("const capture_wire = 1;") != std::string::npos);
+    CHECK(js.find("function webcc_capture()") != std::string::npos);
+
+    generate_js_runtime(defs, imports, markers, {}, "/tmp");
+    CHECK(read_file("/tmp/app.js").find("capture") == std::string::npos);
+}
+
+TEST(codegen_js_coalesces_events)
+{
+    SchemaDefs defs = real_defs();
+    std::set<std::string> imports = {"webcc_js_flush"};
+    auto markers = void_markers(defs, {"input::init_mouse"});
+    generate_js_runtime(defs, imports, markers, {}, "/tmp");
+    std::string js = read_file("/tmp/app.js");
+
+    // MOUSE_MOVE (coalesce=last) overwrites, WHEEL (accumulate) adds, and
+    // MOUSE_DOWN is always queued.
+    CHECK(js.find("let event_last_pos = -1, event_last_end = -1, event_claimed = 0;") != std::string::npos);
+    size_t move = js.find("function push_event_input_MOUSE_MOVE(x, y) {");
+    size_t wheel = js.find("function push_event_input_WHEEL(dx, dy) {");
+    size_t down = js.find("function push_event_input_MOUSE_DOWN(button, x, y) {");
+    CHECK(move != std::string::npos && wheel != std::string::npos && down != std::string::npos);
+    if (move == std::string::npos || wheel == std::string::npos || down == std::string::npos)
+        return;
+    std::string move_fn = js.substr(move, js.find("function ", move + 1) - move);
+    std::string wheel_fn = js.substr(wheel, js.find("function ", wheel + 1) - wheel);
+    std::string down_fn = js.substr(down, js.find("function ", down + 1) - down);
+    // Folding claims the open record and hands it back; new records are
+    // published open.
+    CHECK(move_fn.find("if (event_claim(") != std::string::npos);
+    CHECK(move_fn.find("event_i32[pos >> 2] = x; pos += 4;") < move_fn.find("event_unclaim();"));
+    CHECK(move_fn.find("event_u8[pos + 1] = 2; // flags") != std::string::npos);
+    CHECK(down_fn.find("event_u8[pos + 1] = 0; // flags") != std::string::npos);
+    CHECK(wheel_fn.find("event_f32[pos >> 2] += dx; pos += 4;") != std::string::npos);
+    CHECK(down_fn.find("event_last_pos") == std::string::npos);
+    // Exact headroom instead of a flat 4096 bytes.
+    CHECK(down_fn.find("let pos = event_reserve(16);") != std::string::npos);
+}
+
+// An event the app unsubscribed from is dropped before its string is encoded
+// or any view is touched; the header maps mask bits back to opcodes.
+TEST(codegen_events_honor_subscriptions)
+{
+    SchemaDefs defs = real_defs();
+    std::set<std::string> imports = {"webcc_js_flush"};
+    auto markers = void_markers(defs, {"system::init_popstate"});
+    generate_js_runtime(defs, imports, markers, {}, "/tmp");
+    std::string js = read_file("/tmp/app.js");
+
+    const SchemaEvent *popstate = nullptr;
+    for (const auto &e : defs.events)
+        if (e.ns == "system" && e.name == "POPSTATE")
+            popstate = &e;
+    CHECK(popstate != nullptr);
+    if (!popstate)
+        return;
+    std::string muted = "if (event_ring[" + std::to_string(18 + (popstate->opcode >> 5)) + "] & (1 << " +
+                        std::to_string(popstate->opcode & 31) + ")) return;";
+    size_t fn = js.find("function push_event_system_POPSTATE(path) {");
+    CHECK(fn != std::string::npos);
+    if (fn == std::string::npos)
+        return;
+    size_t check = js.find(muted, fn);
+    CHECK(check != std::string::npos);
+    CHECK(check < js.find("text_encoder.encode(path)", fn));
+
+    std::string input = emit_header_in_temp(defs, "input.h");
+    CHECK(input.find("constexpr uint8_t EVENT_OPCODES[] = {EVENT_KEY_DOWN, EVENT_KEY_UP,") != std::string::npos);
+    CHECK(input.find("inline void subscribe(uint32_t mask) {") != std::string::npos);
+    CHECK(input.find("if (mask & (1u << i)) webcc::unsubscribe_event(EVENT_OPCODES[i]);") != std::string::npos);
+}
+
+// A batched event appends samples to the unread block at the end of the ring;
+// C++ reads its columns in place.
+TEST(codegen_batched_events_are_struct_of_arrays)
+{
+    SchemaDefs defs = real_defs();
+    std::set<std::string> imports = {"webcc_js_flush"};
+    auto markers = void_markers(defs, {"input::init_pointer"});
+    generate_js_runtime(defs, imports, markers, {}, "/tmp");
+    std::string js = read_file("/tmp/app.js");
+
+    size_t at = js.find("function push_event_input_POINTER(id, phase, x, y, pressure, buttons, movement_x, movement_y, time) {");
+    CHECK(at != std::string::npos);
+    if (at == std::string::npos)
+        return;
+    std::string fn = js.substr(at, js.find("function ", at + 1) - at);
+    CHECK(fn.find("i = event_i32[(at + 4) >> 2];") != std::string::npos);
+    CHECK(fn.find("if (i < 32) { pos = at; event_i32[(at + 4) >> 2] = i + 1; }") != std::string::npos);
+    CHECK(fn.find("event_claimed &= ~0x200; event_unclaim();") != std::string::npos);
+    // 8 header bytes, eight 4-byte columns, one aligned float64 column.
+    CHECK(fn.find("pos = event_reserve(1292);") != std::string::npos);
+    CHECK(fn.find("event_f32[(col >> 2) + i] = x; col += 128;") != std::string::npos);
+    CHECK(fn.find("event_f64[(col >> 3) + i] = time; col += 256;") != std::string::npos);
+    CHECK(fn.find("if (i === 0) {") < fn.find("event_publish(len);"));
+    CHECK(fn.find("event_publish(len);") < fn.find("event_unclaim();", fn.find("if (i === 0) {")));
+    CHECK(js.find("'pointerrawupdate'") != std::string::npos);
+
+    std::string input = emit_header_in_temp(defs, "input.h");
+    CHECK(input.find("static constexpr uint32_t CAPACITY = 32;") != std::string::npos);
+    CHECK(input.find("const int32_t* id;") != std::string::npos);
+    CHECK(input.find("res.x = (const float*)(data + offset); offset += 128;") != std::string::npos);
+    CHECK(input.find("res.time = (const double*)(data + offset); offset += 256;") != std::string::npos);
+}
+
+// --stats builds stamp every new record after its header and provide the
+// clock C++ compares against; plain builds do neither.
+TEST(codegen_stats_builds_stamp_events)
+{
+    SchemaDefs defs = real_defs();
+    std::set<std::string> imports = {"webcc_js_flush"};
+    auto markers = void_markers(defs, {"input::init_mouse", "input::init_pointer"});
+    JsRuntimeOptions opts;
+    opts.stats = true;
+    generate_js_runtime(defs, imports, markers, {}, "/tmp", opts);
+    std::string js = read_file("/tmp/app.js");
+
+    const std::string stamp = "event_u8[pos + 1] = 1; event_i32[(pos + 4) >> 2] = (performance.now() * 1000) >>> 0;";
+    CHECK(js.find("webcc_stats_now_us: () => (performance.now() * 1000) >>> 0") != std::string::npos);
+    size_t down = js.find("function push_event_input_MOUSE_DOWN(button, x, y) {");
+    CHECK(down != std::string::npos);
+    if (down == std::string::npos)
+        return;
+    std::string down_fn = js.substr(down, js.find("function ", down + 1) - down);
+    CHECK(down_fn.find("let pos = event_reserve(20);") != std::string::npos);
+    CHECK(down_fn.find(stamp) != std::string::npos);
+    CHECK(down_fn.find("pos += 8;") != std::string::npos);
+    // Folding skips the stamp too; the first push's time is kept.
+    CHECK(js.find("let pos = (event_last_pos & EVENT_RING_MASK) + 8;") != std::string::npos);
+    CHECK(js.find("pos = event_reserve(1296);") != std::string::npos);
+    CHECK(js.find("let col = pos + 12;") != std::string::npos);
+
+    generate_js_runtime(defs, imports, markers, {}, "/tmp");
+    js = read_file("/tmp/app.js");
+    CHECK(js.find(stamp) == std::string::npos);
+    CHECK(js.find("webcc_stats_now_us") == std::string::npos);
+}
+
+// A long string is written once into a heap block from webcc_event_alloc();
+// the record carries [len | DETACHED][ptr] and the pointer again at its end.
+TEST(codegen_long_event_strings_go_out_of_band)
+{
+    SchemaDefs defs = real_defs();
+    std::set<std::string> imports = {"webcc_js_flush", "webcc_websocket_connect"};
+    generate_js_runtime(defs, imports, {}, {}, "/tmp");
+    std::string js = read_file("/tmp/app.js");
+
+    CHECK(js.find("webcc_event_alloc, webcc_frame_end, webcc_heap_stats_ptr, webcc_scratch_buffer_ptr } = mod.instance.exports;") != std::string::npos);
+    size_t at = js.find("function push_event_websocket_MESSAGE(handle, data) {");
+    CHECK(at != std::string::npos);
+    if (at == std::string::npos)
+        return;
+    std::string fn = js.substr(at, js.find("function ", at + 1) - at);
+    CHECK(fn.find("const big_1 = len_1 > 4096;") != std::string::npos);
+    CHECK(fn.find("let pos = event_reserve(12 + (big_1 ? 8 : ((len_1 + 3) & ~3)));") != std::string::npos);
+    // Allocating can grow the memory: the views are refreshed after it.
+    size_t alloc = fn.find("const ptr_1 = big_1 ? webcc_event_alloc(len_1) : 0;");
+    CHECK(alloc != std::string::npos);
+    CHECK(fn.find("if (event_u8.buffer !== memory.buffer) event_views();", alloc) != std::string::npos);
+    CHECK(fn.find("new Uint8Array(memory.buffer, ptr_1, len_1).set(encoded_1);") != std::string::npos);
+    CHECK(fn.find("event_u8[start_pos + 1] |= (big_1) << 4;") != std::string::npos);
+
+    std::string ws = emit_header_in_temp(defs, "websocket.h");
+    CHECK(ws.find("if (data_len & webcc::EVENT_DETACHED) {") != std::string::npos);
+    CHECK(ws.find("res.data = webcc::string_view((const char*)(uintptr_t)*(uint32_t*)(data + offset), data_len & ~webcc::EVENT_DETACHED);") != std::string::npos);
+}
+
+TEST(codegen_strip_js_diagnostics)
+{
+    CHECK_EQ(strip_js_diagnostics("{ if(!ctx){ console.warn('no ctx:', h); continue; } ctx.x = 1; }"),
+             std::string("{ if(!ctx){ continue; } ctx.x = 1; }"));
+    // Values the user asked to log stay.
+    CHECK_EQ(strip_js_diagnostics("{ console.warn(msg); }"), std::string("{ console.warn(msg); }"));
+    // Outside statement position the call is replaced, not dropped.
+    CHECK_EQ(strip_js_diagnostics("p.catch(e => console.error(\"failed (\", e));"),
+             std::string("p.catch(e => 0);"));
+    CHECK_EQ(strip_js_diagnostics("if(!ok) console.error('bad'); go();"), std::string("if(!ok) 0; go();"));
+}
+
 // --- WEBCC_JS inline-JavaScript escape hatch -------------------------------
 // Named WEBCC_JS functions reach the generator as imports from module "wjs_fn",
 // each of the form `name(params){body}` (the JS source itself). main.cc reads
@@ -270,3 +753,25 @@ TEST(codegen_headers_snapshot)
     check_snapshot("handles.h", handles);
     check_snapshot("canvas.h", canvas);
 }
+
+// dispatch_events() is one switch over every event opcode in the schema, each
+// case parsing into the struct of its own namespace.
+TEST(codegen_events_header_dispatches_with_one_switch)
+{
+    SchemaDefs defs = real_defs();
+    std::string events = emit_header_in_temp(defs, "events.h");
+    CHECK(!events.empty());
+
+    CHECK(events.find("#include \"input.h\"") != std::string::npos);
+    CHECK(events.find("#include \"canvas.h\"") == std::string::npos); // no events
+    CHECK(events.find("inline void dispatch_events(Handlers... handlers) {") != std::string::npos);
+    CHECK_EQ(events.find("switch (e.opcode)"), events.rfind("switch (e.opcode)"));
+    CHECK(events.find("case webcc::input::EVENT_MOUSE_MOVE: webcc::detail::dispatch_event<webcc::input::MouseMoveEvent>(h, e); break;") != std::string::npos);
+    CHECK(events.find("case webcc::wgpu::EVENT_DEVICE_READY: webcc::detail::dispatch_event<webcc::wgpu::DeviceReadyEvent>(h, e); break;") != std::string::npos);
+    CHECK(events.find("default: webcc::detail::dispatch_other(h, e); break;") != std::string::npos);
+
+    size_t cases = 0;
+    for (size_t at = events.find("case "); at != std::string::npos; at = events.find("case ", at + 1))
+        ++cases;
+    CHECK_EQ(cases, defs.events.size());
+}
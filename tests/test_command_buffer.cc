@@ -7,11 +7,24 @@
 // layout so the two stay in sync.
 #include "framework.h"
 #include "command_buffer.h"
+#include "webcc/core/intern.h"
+#include "webcc/core/display_list.h"
+#include "webcc/core/stats.h"
+#include "webcc/webcc.h"
 
 #include <cstring>
 
 using webcc::CommandBuffer;
 
+namespace webcc
+{
+    void flush(); // command_buffer.cc
+}
+
+// Built-in feature markers are wasm imports; host builds just need a symbol.
+extern "C" void __webcc_m_255(void) {}
+extern "C" void __webcc_m_253(void) {}
+
 namespace
 {
     // Helpers to read back little-endian values from the buffer.
@@ -120,6 +133,26 @@ TEST(command_buffer_string_aligned_length_no_padding)
     CHECK_EQ(read_u32(CommandBuffer::data()), 4u);
 }
 
+TEST(command_buffer_string_padding_overwrites_stale_bytes)
+{
+    // Leave non-zero bytes where the next batch's padding will go.
+    CommandBuffer::reset();
+    for (int i = 0; i < 4; ++i)
+        CommandBuffer::push_u32(0xFFFFFFFFu);
+    CommandBuffer::reset();
+
+    CommandBuffer::push_string("abcde", 5);
+    CommandBuffer::push_u32(7);
+    // [u32 len=5][a b c d e][pad 3][u32 7] => 16 bytes
+    CHECK_EQ(CommandBuffer::size(), (size_t)16);
+    const uint8_t *d = CommandBuffer::data();
+    CHECK_EQ((int)d[8], 'e');
+    CHECK_EQ((int)d[9], 0);
+    CHECK_EQ((int)d[10], 0);
+    CHECK_EQ((int)d[11], 0);
+    CHECK_EQ(read_u32(d + 12), 7u);
+}
+
 TEST(command_buffer_empty_string)
 {
     CommandBuffer::reset();
@@ -162,3 +195,451 @@ TEST(command_buffer_fill_rect_like_sequence)
     std::memcpy(&x, &bits, 8);
     CHECK_EQ(x, 10.0);
 }
+
+// The cursor used by the generated wrappers must produce exactly the bytes the
+// push_* helpers do, including double padding at both start parities.
+TEST(command_cursor_matches_push_encoding)
+{
+    for (uint32_t lead = 0; lead < 2; ++lead)
+    {
+        CommandBuffer::reset();
+        if (lead)
+            CommandBuffer::push_u32(0xEEEEEEEEu);
+        CommandBuffer::push_u32(0x10);
+        CommandBuffer::push_i32(7);
+        CommandBuffer::push_double(1.25);
+        CommandBuffer::push_string("hey", 3);
+        CommandBuffer::push_double(-8.0);
+        size_t n = CommandBuffer::size();
+        uint8_t expected[64];
+        std::memcpy(expected, CommandBuffer::data(), n);
+
+        CommandBuffer::reset();
+        if (lead)
+            CommandBuffer::push_u32(0xEEEEEEEEu);
+        webcc::CommandCursor c = CommandBuffer::reserve(48);
+        CHECK(bool(c));
+        if (!c)
+            return;
+        c.u32(0x10);
+        c.i32(7);
+        c.f64(1.25);
+        c.str("hey", 3);
+        c.f64(-8.0);
+        CommandBuffer::commit(c);
+
+        CHECK_EQ(CommandBuffer::size(), n);
+        CHECK(std::memcmp(CommandBuffer::data(), expected, n) == 0);
+    }
+}
+
+namespace
+{
+    // Fill the buffer until fewer than 8 bytes remain.
+    void fill_until_nearly_full()
+    {
+        CommandBuffer::reset();
+        CommandBuffer::push_u32(0xC0FFEEu);
+        while (CommandBuffer::size() + 8 <= CommandBuffer::capacity())
+            CommandBuffer::push_u32(1);
+    }
+}
+
+// Default policy: a command that does not fit flushes what is pending and then
+// lands whole at the start of the emptied buffer.
+TEST(command_buffer_overflow_flushes_before_writing)
+{
+    fill_until_nearly_full();
+    uint32_t flushes = CommandBuffer::stats().overflow_flushes;
+
+    webcc::push_command(0x10, 2.5, webcc::string_view("abcdefgh", 8)); // does not fit -> flush
+
+    CHECK_EQ(CommandBuffer::stats().overflow_flushes, flushes + 1);
+    CHECK_EQ(CommandBuffer::capacity(), (size_t)1024 * 1024);
+    // The whole command moved to the new batch: [op][pad][double][len][8 bytes].
+    CHECK_EQ(CommandBuffer::size(), (size_t)(4 + 4 + 8 + 12));
+    CHECK_EQ(read_u32(CommandBuffer::data()), 0x10u);
+    double x;
+    uint64_t bits = read_u64(CommandBuffer::data() + 8);
+    std::memcpy(&x, &bits, 8);
+    CHECK_EQ(read_u32(CommandBuffer::data() + 16), 8u);
+    CHECK_EQ(x, 2.5);
+    CommandBuffer::reset();
+}
+
+// Grow policy: pending commands are kept and the buffer is enlarged by a segment.
+TEST(command_buffer_grow_policy_keeps_pending_commands)
+{
+    CommandBuffer::set_overflow_policy(webcc::OverflowPolicy::Grow);
+    fill_until_nearly_full();
+    size_t before = CommandBuffer::size();
+    uint32_t grows = CommandBuffer::stats().grows;
+
+    CommandBuffer::push_string("abcdefgh", 8);
+
+    CHECK_EQ(CommandBuffer::stats().grows, grows + 1);
+    CHECK_EQ(CommandBuffer::capacity(), (size_t)2 * 1024 * 1024);
+    CHECK_EQ(CommandBuffer::size(), before + 12);
+    CHECK_EQ(read_u32(CommandBuffer::data()), 0xC0FFEEu);
+    CHECK_EQ(read_u32(CommandBuffer::data() + before), 8u);
+    CHECK(CommandBuffer::stats().high_water <= CommandBuffer::capacity());
+
+    // trim() is a no-op while commands are pending.
+    CommandBuffer::trim();
+    CHECK_EQ(CommandBuffer::capacity(), (size_t)2 * 1024 * 1024);
+    CommandBuffer::reset();
+    CommandBuffer::trim();
+    CHECK_EQ(CommandBuffer::capacity(), (size_t)1024 * 1024);
+    CHECK(CommandBuffer::stats().high_water >= before + 12);
+    CommandBuffer::set_overflow_policy(webcc::OverflowPolicy::Flush);
+}
+
+// The flushed buffer becomes the snapshot and is no longer the producer, so
+// trim() must free its grown block too, moving a small snapshot home first.
+TEST(command_buffer_trim_frees_the_snapshot_slot)
+{
+    CommandBuffer::set_overflow_policy(webcc::OverflowPolicy::Grow);
+    fill_until_nearly_full();
+    CommandBuffer::push_string("abcdefgh", 8);
+    CHECK_EQ(CommandBuffer::capacity(), (size_t)2 * 1024 * 1024);
+    CommandBuffer::reset();
+    CommandBuffer::push_u32(0xAAAA0001u);
+    const uint8_t *grown = CommandBuffer::data();
+    webcc::flush();
+    CHECK(CommandBuffer::snapshot_data() == grown);
+
+    CommandBuffer::trim();
+    CHECK(CommandBuffer::snapshot_data() != grown);
+    CHECK_EQ(CommandBuffer::snapshot_size(), (size_t)4);
+    CHECK_EQ(read_u32(CommandBuffer::snapshot_data()), 0xAAAA0001u);
+
+    // The next flush swaps back onto the trimmed slot.
+    CommandBuffer::push_u32(0xAAAA0002u);
+    webcc::flush();
+    CHECK_EQ(CommandBuffer::capacity(), (size_t)1024 * 1024);
+    CommandBuffer::set_overflow_policy(webcc::OverflowPolicy::Flush);
+}
+
+// A single command larger than the whole buffer grows it even under Flush.
+TEST(command_buffer_oversized_command_grows)
+{
+    CommandBuffer::reset();
+    size_t len = 1536 * 1024;
+    char *big = new char[len];
+    std::memset(big, 'x', len);
+    CommandBuffer::push_string(big, len);
+    delete[] big;
+
+    CHECK_EQ(CommandBuffer::size(), 4 + len);
+    CHECK(CommandBuffer::capacity() >= 4 + len);
+    CommandBuffer::reset();
+    CommandBuffer::trim();
+}
+
+// A reservation is all-or-nothing: when neither flushing nor growth can make
+// room, nothing is written and the drop is counted.
+TEST(command_buffer_reserve_never_writes_partial_command)
+{
+    CommandBuffer::reset();
+    CommandBuffer::push_u32(1);
+    uint32_t dropped = CommandBuffer::stats().dropped;
+
+    // Larger than the host heap arena: growth must fail.
+    CHECK(!CommandBuffer::reserve((size_t)512 * 1024 * 1024));
+    CHECK_EQ(CommandBuffer::stats().dropped, dropped + 1);
+    CHECK_EQ(CommandBuffer::size(), (size_t)0); // pending bytes were flushed first
+
+    CommandBuffer::reset();
+}
+
+// flush() hands the producer buffer to JS and swaps: the flushed bytes stay
+// intact as the snapshot while the next frame is encoded into the other buffer.
+TEST(command_buffer_swap_keeps_snapshot_while_encoding)
+{
+    CommandBuffer::reset();
+    CommandBuffer::push_u32(0xAAAA0001u);
+    CommandBuffer::push_u32(0xAAAA0002u);
+    const uint8_t *frame1 = CommandBuffer::data();
+    webcc::flush();
+
+    CHECK(CommandBuffer::snapshot_data() == frame1);
+    CHECK_EQ(CommandBuffer::snapshot_size(), (size_t)8);
+    CHECK_EQ(CommandBuffer::size(), (size_t)0);
+    CHECK(CommandBuffer::data() != frame1);
+
+    CommandBuffer::push_u32(0xBBBB0001u);
+    CHECK_EQ(read_u32(CommandBuffer::snapshot_data()), 0xAAAA0001u);
+    CHECK_EQ(read_u32(CommandBuffer::snapshot_data() + 4), 0xAAAA0002u);
+
+    // The next flush swaps back: frame 1's buffer is reused for frame 3.
+    const uint8_t *frame2 = CommandBuffer::data();
+    webcc::flush();
+    CHECK(CommandBuffer::snapshot_data() == frame2);
+    CHECK_EQ(CommandBuffer::snapshot_size(), (size_t)4);
+    CHECK(CommandBuffer::data() == frame1);
+    CommandBuffer::reset();
+}
+
+// flush() of an empty buffer is a no-op: it must not discard the snapshot.
+TEST(command_buffer_empty_flush_keeps_snapshot)
+{
+    CommandBuffer::reset();
+    CommandBuffer::push_u32(42);
+    webcc::flush();
+    const uint8_t *snap = CommandBuffer::snapshot_data();
+    webcc::flush();
+    CHECK(CommandBuffer::snapshot_data() == snap);
+    CHECK_EQ(CommandBuffer::snapshot_size(), (size_t)4);
+    CHECK_EQ(read_u32(snap), 42u);
+}
+
+// Compact (v2) format: a run of commands on the same bound handle carries a
+// single BIND, and every batch starts unbound so it decodes on its own.
+TEST(command_cursor_bind_emitted_only_on_change)
+{
+    CommandBuffer::reset();
+    for (int i = 0; i < 3; ++i)
+    {
+        webcc::CommandCursor c = CommandBuffer::reserve(webcc::BIND_SIZE + 1);
+        c.bind(0, 7);
+        c.u8(0x25);
+        CommandBuffer::commit(c);
+    }
+    // [BIND 0 7][op][op][op]
+    CHECK_EQ(CommandBuffer::size(), webcc::BIND_SIZE + 3);
+    const uint8_t *d = CommandBuffer::data();
+    CHECK_EQ((int)d[0], (int)webcc::OP_BIND);
+    CHECK_EQ((int)d[1], 0);
+    CHECK_EQ(read_u32(d + 2), 7u);
+    CHECK_EQ((int)d[6], 0x25);
+
+    webcc::flush();
+    webcc::CommandCursor c = CommandBuffer::reserve(webcc::BIND_SIZE + 1);
+    c.bind(0, 7);
+    c.u8(0x25);
+    CommandBuffer::commit(c);
+    CHECK_EQ(CommandBuffer::size(), webcc::BIND_SIZE + 1);
+    CommandBuffer::reset();
+}
+
+TEST(command_cursor_packed_values_are_unaligned)
+{
+    CommandBuffer::reset();
+    webcc::CommandCursor c = CommandBuffer::reserve(32);
+    c.u8(3);
+    c.f64_packed(0.5);
+    c.str_packed("abc", 3);
+    c.u8(9);
+    CommandBuffer::commit(c);
+
+    // 1 + 8 + (4 + 3) + 1, no padding anywhere.
+    CHECK_EQ(CommandBuffer::size(), (size_t)17);
+    const uint8_t *d = CommandBuffer::data();
+    double x;
+    uint64_t bits = read_u64(d + 1);
+    std::memcpy(&x, &bits, 8);
+    CHECK_EQ(x, 0.5);
+    CHECK_EQ(read_u32(d + 9), 3u);
+    CHECK_EQ((int)d[13], 'a');
+    CHECK_EQ((int)d[16], 9);
+    CommandBuffer::reset();
+}
+
+// intern() registers the string once: [INTERN][id][len][bytes]. Uses of the id
+// carry INTERNED_BIT | id in the length field and no bytes.
+TEST(intern_registers_once_then_sends_id)
+{
+    CommandBuffer::reset();
+    webcc::interned font = webcc::intern("30px Arial");
+    webcc::interned cls = webcc::intern("row");
+    CHECK(font.id() != cls.id());
+
+    const uint8_t *d = CommandBuffer::data();
+    CHECK_EQ(read_u32(d), (uint32_t)webcc::OP_INTERN);
+    CHECK_EQ(read_u32(d + 4), font.id());
+    CHECK_EQ(read_u32(d + 8), 10u);
+    CHECK(std::memcmp(d + 12, "30px Arial", 10) == 0);
+    size_t first = 12 + 12; // 10 bytes padded to 12
+    CHECK_EQ(read_u32(d + first), (uint32_t)webcc::OP_INTERN);
+    CHECK_EQ(read_u32(d + first + 4), cls.id());
+
+    webcc::flush();
+    webcc::string_arg arg = font;
+    CHECK_EQ(arg.length(), 0u);
+    webcc::CommandCursor c = CommandBuffer::reserve(4 + webcc::CommandCursor::pad4(arg.length()));
+    c.str(arg.data(), arg.length(), arg.ref());
+    CommandBuffer::commit(c);
+    CHECK_EQ(CommandBuffer::size(), (size_t)4);
+    CHECK_EQ(read_u32(CommandBuffer::data()), webcc::INTERNED_BIT | font.id());
+    CommandBuffer::reset();
+}
+
+// The ids are handed out already, so reset() keeps the registrations and
+// drops only the commands around them.
+TEST(intern_survives_command_buffer_reset)
+{
+    CommandBuffer::reset();
+    CommandBuffer::push_u32(0x11);
+    webcc::interned name = webcc::intern("name");
+    CommandBuffer::push_u32(0x12);
+    CommandBuffer::reset();
+
+    CHECK_EQ(CommandBuffer::size(), (size_t)16);
+    const uint8_t *d = CommandBuffer::data();
+    CHECK_EQ(read_u32(d), (uint32_t)webcc::OP_INTERN);
+    CHECK_EQ(read_u32(d + 4), name.id());
+    CHECK_EQ(read_u32(d + 8), 4u);
+    CHECK(std::memcmp(d + 12, "name", 4) == 0);
+
+    // Once flushed they are JS's, and the next reset() has nothing to keep.
+    webcc::flush();
+    CommandBuffer::push_u32(0x13);
+    CommandBuffer::reset();
+    CHECK_EQ(CommandBuffer::size(), (size_t)0);
+}
+
+TEST(string_arg_plain_bytes_have_no_ref)
+{
+    webcc::string_arg a = "abc";
+    CHECK_EQ(a.length(), 3u);
+    CHECK_EQ(a.ref(), 0u);
+    webcc::string s("hello");
+    webcc::string_arg b = s;
+    CHECK_EQ(b.length(), 5u);
+    CHECK(b.data() == s.c_str());
+}
+
+// A record is bracketed by [BEGIN_RECORD id] ... [END_RECORD]; replay() is a
+// single [REPLAY id]. Records do not nest.
+TEST(display_list_record_and_replay_encoding)
+{
+    CommandBuffer::reset();
+    webcc::display_list list = webcc::begin_record();
+    CHECK(list.is_valid());
+    CHECK(!webcc::begin_record().is_valid());
+    CommandBuffer::push_u32(0x11);
+    webcc::end_record();
+    webcc::replay(list);
+    webcc::discard(list);
+
+    CHECK_EQ(CommandBuffer::size(), (size_t)32);
+    const uint8_t *d = CommandBuffer::data();
+    CHECK_EQ(read_u32(d), (uint32_t)webcc::OP_BEGIN_RECORD);
+    CHECK_EQ(read_u32(d + 4), (uint32_t)list.value);
+    CHECK_EQ(read_u32(d + 8), 0x11u);
+    CHECK_EQ(read_u32(d + 12), (uint32_t)webcc::OP_END_RECORD);
+    CHECK_EQ(read_u32(d + 16), (uint32_t)webcc::OP_REPLAY);
+    CHECK_EQ(read_u32(d + 20), (uint32_t)list.value);
+    CHECK_EQ(read_u32(d + 24), (uint32_t)webcc::OP_DISCARD_LIST);
+    CHECK_EQ(read_u32(d + 28), (uint32_t)list.value);
+
+    webcc::display_list next = webcc::begin_record();
+    CHECK(next.is_valid() && next != list);
+    webcc::end_record();
+    webcc::flush();
+}
+
+// reset() drops what was recorded but not the bracket itself: JS must still
+// see the record open, and close, as C++ did.
+TEST(display_list_bracket_survives_command_buffer_reset)
+{
+    CommandBuffer::reset();
+    webcc::display_list list = webcc::begin_record();
+    CommandBuffer::push_u32(0x11);
+    CommandBuffer::reset();
+    CHECK_EQ(CommandBuffer::size(), (size_t)8);
+    CHECK_EQ(read_u32(CommandBuffer::data()), (uint32_t)webcc::OP_BEGIN_RECORD);
+    CHECK_EQ(read_u32(CommandBuffer::data() + 4), (uint32_t)list.value);
+
+    CommandBuffer::push_u32(0x12);
+    webcc::end_record();
+    CommandBuffer::push_u32(0x13);
+    CommandBuffer::reset();
+    CHECK_EQ(CommandBuffer::size(), (size_t)12);
+    CHECK_EQ(read_u32(CommandBuffer::data() + 8), (uint32_t)webcc::OP_END_RECORD);
+    webcc::flush();
+}
+
+// A list must decode on its own and must not trust registers set by whatever
+// ran before a replay, so recording and replaying both reset the binds.
+TEST(display_list_resets_bind_registers)
+{
+    CommandBuffer::reset();
+    webcc::CommandCursor c = CommandBuffer::reserve(webcc::BIND_SIZE);
+    c.bind(0, 7);
+    CommandBuffer::commit(c);
+    webcc::display_list list = webcc::begin_record();
+    CHECK_EQ(webcc::detail::cmd_bound[0], INT32_MIN);
+
+    c = CommandBuffer::reserve(webcc::BIND_SIZE);
+    c.bind(0, 7);
+    CommandBuffer::commit(c);
+    webcc::replay(list);
+    CHECK_EQ(webcc::detail::cmd_bound[0], INT32_MIN);
+    webcc::end_record();
+    webcc::flush();
+}
+
+// The suite builds with WEBCC_STATS, so commits are counted per opcode and
+// flushes are attributed to what caused them.
+namespace
+{
+    int g_flush_hook_calls = 0;
+    void count_flush_hook(const webcc::stats::FlushStats &) { g_flush_hook_calls++; }
+}
+
+TEST(stats_count_commands_by_opcode)
+{
+    CommandBuffer::reset();
+    webcc::stats::reset();
+    if (webcc::CommandCursor c = CommandBuffer::reserve(12))
+    {
+        c.u32(7);
+        c.i32(1);
+        c.f32(2.0f);
+        CommandBuffer::commit(c);
+    }
+    CommandBuffer::push_u32(7);
+    CommandBuffer::push_u32(9);
+
+    const webcc::stats::FlushStats &p = webcc::stats::pending();
+    CHECK_EQ(p.sent.ops[7].commands, 2u);
+    CHECK_EQ(p.sent.ops[7].bytes, 16u);
+    CHECK_EQ(p.sent.ops[9].commands, 1u);
+    CHECK_EQ(p.sent.all.commands, 3u);
+    CHECK_EQ(p.sent.all.bytes, 20u);
+    constexpr uint8_t ns_ops[] = {7, 8};
+    CHECK_EQ(p.sent.sum(ns_ops).commands, 2u);
+
+    // Discarded commands were never sent.
+    CommandBuffer::reset();
+    CHECK_EQ(webcc::stats::pending().sent.all.commands, 0u);
+}
+
+TEST(stats_attribute_flushes_to_their_cause)
+{
+    CommandBuffer::reset();
+    webcc::stats::reset();
+    g_flush_hook_calls = 0;
+    webcc::stats::set_flush_hook(count_flush_hook);
+
+    CommandBuffer::push_u32(7);
+    webcc::detail::flush_for(webcc::FlushReason::Getter);
+    webcc::flush(); // nothing pending: requested, but not sent
+    CommandBuffer::push_u32(7);
+    webcc::flush();
+
+    const webcc::stats::Totals &t = webcc::stats::totals();
+    CHECK_EQ(t.requests[(int)webcc::FlushReason::Getter], 1u);
+    CHECK_EQ(t.flushes[(int)webcc::FlushReason::Getter], 1u);
+    CHECK_EQ(t.requests[(int)webcc::FlushReason::Explicit], 2u);
+    CHECK_EQ(t.flushes[(int)webcc::FlushReason::Explicit], 1u);
+    CHECK_EQ(t.sent.ops[7].commands, 2u);
+    CHECK(webcc::stats::last_flush().reason == webcc::FlushReason::Explicit);
+    CHECK_EQ(webcc::stats::last_flush().sent.all.bytes, 4u);
+    CHECK_EQ(webcc::stats::pending().sent.all.commands, 0u);
+    CHECK_EQ(g_flush_hook_calls, 2);
+
+    webcc::stats::set_flush_hook(nullptr);
+    CommandBuffer::reset();
+}
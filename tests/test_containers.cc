@@ -5,6 +5,9 @@
 
 #include "webcc/core/vector.h"
 #include "webcc/core/queue.h"
+#include "webcc/core/string.h"
+#include "webcc/core/unordered_map.h"
+#include "webcc/core/object_pool.h"
 #include "framework.h"
 
 using webcc::detail::heap_reset;
@@ -97,7 +100,8 @@ TEST(queue_fifo_preserved_when_wrapped)
         CHECK_EQ(q.front(), i);
         q.pop();
     }
-    // Growth now happens with m_head != 0 -> must take the relinearizing path.
+    // Growth now happens with m_head != 0 and the ring wrapped -> realloc,
+    // then the wrapped front is copied past the old end.
     for (int i = 8; i < 500; ++i)
         q.push(i);
     for (int i = 4; i < 500; ++i)
@@ -107,3 +111,255 @@ TEST(queue_fifo_preserved_when_wrapped)
     }
     CHECK(q.empty());
 }
+
+static_assert(webcc::is_trivially_relocatable_v<int>);
+static_assert(webcc::is_trivially_relocatable_v<webcc::string>);
+static_assert(webcc::is_trivially_relocatable_v<webcc::vector<webcc::string>>);
+static_assert(webcc::is_trivially_relocatable_v<webcc::pair<int, webcc::string>>);
+static_assert(!webcc::is_trivially_relocatable_v<Boxed>);
+
+TEST(vector_insert_and_erase_shift_elements)
+{
+    heap_reset();
+    {
+        // Relocatable: grows with realloc, shifts with memmove.
+        webcc::vector<webcc::string> v;
+        for (int i = 0; i < 127; ++i)
+            v.push_back(webcc::string("s") + i);
+        v.insert(0, webcc::string("first")); // now full at 128
+        v.insert(64, v[0]); // aliases an element, across a reallocation
+        v.insert(v.size(), webcc::string("last"));
+        v.erase(1);
+        CHECK_EQ(v.size(), (size_t)129);
+        CHECK(v[0] == "first");
+        CHECK(v[1] == "s1");
+        CHECK(v[63] == "first");
+        CHECK(v[64] == "s63");
+        CHECK(v[127] == "s126");
+        CHECK(v[128] == "last");
+
+        // Not relocatable: element by element.
+        webcc::vector<Boxed> b;
+        for (int i = 0; i < 10; ++i)
+            b.emplace_back(i);
+        b.insert(3, Boxed(100));
+        b.erase(0);
+        CHECK_EQ(b.size(), (size_t)10);
+        CHECK_EQ(b[2].val(), 100);
+        CHECK_EQ(b[3].val(), 3);
+        CHECK_EQ(b[9].val(), 9);
+    }
+    CHECK_EQ(heap_used(), (size_t)0);
+}
+
+TEST(queue_of_nontrivial_survives_wrapped_growth)
+{
+    heap_reset();
+    {
+        webcc::queue<Boxed> q;
+        for (int i = 0; i < 8; ++i)
+            q.emplace(i);
+        for (int i = 0; i < 4; ++i)
+            q.pop();
+        for (int i = 8; i < 100; ++i) // relinearizing copy, one move at a time
+            q.emplace(i);
+        for (int i = 4; i < 100; ++i)
+        {
+            CHECK_EQ(q.front().val(), i);
+            q.pop();
+        }
+    }
+    CHECK_EQ(heap_used(), (size_t)0);
+}
+
+namespace
+{
+    // heap_reset() pulls the frame arena's block out from under it; start
+    // (and leave) it empty instead of freeing a stale pointer.
+    void forget_frame_arena() { new (&webcc::frame_memory()) webcc::frame_arena(); }
+}
+
+TEST(frame_scope_puts_temporaries_in_the_frame_arena)
+{
+    heap_reset();
+    forget_frame_arena();
+    webcc::string title("persistent title");
+    webcc::vector<int> scores;
+    scores.push_back(1);
+    {
+        webcc::frame_scope scope;
+        webcc::string label = webcc::string::concat("score: ", 42, " / ", 100);
+        webcc::string part = title.substr(0, 10);
+        CHECK(webcc::detail::frame_owned(label.data()));
+        CHECK(webcc::detail::frame_owned(part.data()));
+
+        // A spill past the formatter's stack buffer lands in the arena too.
+        webcc::hybrid_formatter<16> fmt;
+        fmt << "a line that is longer than sixteen bytes";
+        CHECK(fmt.on_heap());
+        CHECK(webcc::detail::frame_owned(fmt.c_str()));
+
+        webcc::vector<int> tmp;
+        for (int i = 0; i < 100; ++i)
+            tmp.push_back(i);
+        CHECK(webcc::detail::frame_owned(tmp.data()));
+        CHECK_EQ(tmp[99], 99);
+
+        // Objects that already own heap memory keep it.
+        title += label;
+        for (int i = 0; i < 100; ++i)
+            scores.push_back(i);
+        scores = webcc::move(tmp);
+        CHECK(!webcc::detail::frame_owned(title.data()));
+        CHECK(!webcc::detail::frame_owned(scores.data()));
+        CHECK_EQ(scores.size(), (size_t)100);
+    }
+    size_t heap_after_frame = heap_used();
+    webcc::webcc_frame_end();
+    CHECK_EQ(webcc::frame_memory().used(), (size_t)0);
+    CHECK(webcc::string_view(title.c_str()) == webcc::string_view("persistent titlescore: 42 / 100"));
+
+    // Outside a scope everything is heap again, and the next frame reuses
+    // the arena from the start without growing the heap.
+    webcc::string heap_str("not temporary");
+    CHECK(!webcc::detail::frame_owned(heap_str.data()));
+    {
+        webcc::frame_scope scope;
+        webcc::string label = webcc::string::concat("frame ", 2);
+        CHECK(webcc::detail::frame_owned(label.data()));
+    }
+    webcc::webcc_frame_end();
+    CHECK(heap_used() <= heap_after_frame + 64);
+    forget_frame_arena();
+}
+
+namespace
+{
+    // Constructed before any frame_scope, so they must stay on the heap.
+    webcc::vector<int> g_items;
+    webcc::string g_title;
+}
+
+TEST(frame_scope_leaves_long_lived_empty_containers_on_the_heap)
+{
+    heap_reset();
+    forget_frame_arena();
+    {
+        webcc::frame_scope scope;
+        g_items.push_back(42);
+        g_title = webcc::string::concat("score ", 7);
+        CHECK(!webcc::detail::frame_owned(g_items.data()));
+        CHECK(!webcc::detail::frame_owned(g_title.data()));
+    }
+    webcc::webcc_frame_end();
+
+    // The next frame reuses the arena from the start.
+    {
+        webcc::frame_scope scope;
+        webcc::string junk = webcc::string::concat("XXXXXXXXXXXXXXXX", 1);
+        webcc::vector<int> tmp;
+        for (int i = 0; i < 64; ++i)
+            tmp.push_back(-1);
+    }
+    webcc::webcc_frame_end();
+    CHECK_EQ(g_items.size(), (size_t)1);
+    CHECK_EQ(g_items[0], 42);
+    CHECK(g_title == "score 7");
+
+    // Hand the buffers back before the next heap_reset().
+    g_items = webcc::vector<int>();
+    g_title = webcc::string();
+    forget_frame_arena();
+}
+
+namespace
+{
+    webcc::vector<webcc::string> g_names;
+}
+
+// The elements a long-lived container constructs belong to it, not to the
+// scope they were pushed in: they must survive the frame too.
+TEST(frame_scope_leaves_elements_of_long_lived_containers_on_the_heap)
+{
+    heap_reset();
+    forget_frame_arena();
+    {
+        // queue and unordered_map never use the arena for themselves.
+        webcc::queue<webcc::string> log;
+        webcc::unordered_map<int, webcc::string> labels;
+        {
+            webcc::frame_scope scope;
+            g_names.push_back(webcc::string("hello-world-name"));
+            g_names.push_back("literal-pushed");
+            g_names.emplace_back("emplaced-name");
+            log.push(webcc::string("queued-line"));
+            labels[1] = "label-one";
+            for (int i = 0; i < 8; ++i)
+                g_names.push_back(""); // grows: the first three are moved
+            g_names[3] += "appended later";
+        }
+        webcc::webcc_frame_end();
+
+        {
+            webcc::frame_scope scope;
+            webcc::string junk = webcc::string::concat("XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX", 1);
+            webcc::vector<int> tmp;
+            for (int i = 0; i < 64; ++i)
+                tmp.push_back(-1);
+        }
+        webcc::webcc_frame_end();
+
+        CHECK(g_names[0] == "hello-world-name");
+        CHECK(g_names[1] == "literal-pushed");
+        CHECK(g_names[2] == "emplaced-name");
+        CHECK(g_names[3] == "appended later");
+        for (size_t i = 0; i < 4; ++i)
+            CHECK(!webcc::detail::frame_owned(g_names[i].c_str()));
+        CHECK(log.front() == "queued-line");
+        CHECK(labels[1] == "label-one");
+    }
+
+    // Hand the buffers back before the next heap_reset().
+    g_names = webcc::vector<webcc::string>();
+    forget_frame_arena();
+}
+
+TEST(object_pool_reuses_slots_and_rejects_stale_handles)
+{
+    heap_reset();
+    {
+        webcc::object_pool<Boxed, 4> pool;
+        Boxed *a = pool.create(1);
+        Boxed *b = pool.create(2);
+        CHECK_EQ(pool.size(), (uint32_t)2);
+        CHECK_EQ(pool.capacity(), (uint32_t)4);
+        CHECK_EQ((char *)b - (char *)a, (ptrdiff_t)(sizeof(Boxed) + 8)); // slab neighbours
+
+        webcc::pool_handle<Boxed> ha = pool.handle_of(a);
+        CHECK(pool.get(ha) == a);
+        pool.destroy(a);
+        CHECK(pool.get(ha) == nullptr);
+
+        // The freed slot is handed out next; the old handle stays stale.
+        Boxed *c = pool.create(3);
+        CHECK(c == a);
+        CHECK(pool.get(ha) == nullptr);
+        CHECK(pool.get(pool.handle_of(c)) == c);
+
+        // A fifth object needs a second slab.
+        for (int i = 0; i < 3; ++i)
+            pool.create(10 + i);
+        CHECK_EQ(pool.capacity(), (uint32_t)8);
+        CHECK_EQ(*b->p, 2);
+
+        webcc::pool_handle<Boxed> hb = pool.handle_of(b);
+        pool.clear(); // runs every destructor, keeps the slabs
+        CHECK_EQ(pool.size(), (uint32_t)0);
+        CHECK_EQ(pool.capacity(), (uint32_t)8);
+        CHECK(pool.get(hb) == nullptr);
+        CHECK(pool.create(4) == a); // lowest slot first after a clear
+    }
+    // Boxed frees its int on destruction: a leaked or doubly destroyed
+    // object would leave the heap non-empty or corrupt it.
+    CHECK_EQ(heap_used(), (size_t)0);
+}
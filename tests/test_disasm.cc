@@ -0,0 +1,149 @@
+// Tests for `webcc disasm`: captures are built here byte by byte, the way
+// app.js writes them (see disasm.h), around command bytes produced by the
+// real CommandBuffer, and decoded against the real schema.
+#include "framework.h"
+#include "schema.h"
+#include "disasm.h"
+#include "command_buffer.h"
+
+#include <cstring>
+#include <sstream>
+#include <string>
+
+using namespace webcc;
+
+namespace
+{
+    struct CaptureWriter
+    {
+        std::string out;
+
+        explicit CaptureWriter(uint32_t wire)
+        {
+            out = "WCCP";
+            u32(CAPTURE_FORMAT);
+            u32(wire);
+            u32(0);
+        }
+        void u32(uint32_t v) { out.append((const char *)&v, 4); }
+        void f64(double v) { out.append((const char *)&v, 8); }
+        void bytes(const void *p, size_t n)
+        {
+            out.append((const char *)p, n);
+            out.append((4 - (n & 3)) & 3, '\0');
+        }
+        void head(uint8_t kind, uint32_t frame)
+        {
+            u32(kind);
+            u32(frame);
+        }
+        // The pending command buffer, as webcc_js_flush() would see it.
+        void flush(uint32_t frame)
+        {
+            head(CAPTURE_FLUSH, frame);
+            u32((uint32_t)(uintptr_t)CommandBuffer::data());
+            u32((uint32_t)CommandBuffer::size());
+            bytes(CommandBuffer::data(), CommandBuffer::size());
+            CommandBuffer::reset();
+        }
+    };
+
+    uint8_t opcode_of(const SchemaDefs &defs, const std::string &func)
+    {
+        for (const auto &c : defs.commands)
+            if (c.func_name == func)
+                return c.opcode;
+        return 0;
+    }
+
+    std::string disasm(const SchemaDefs &defs, const std::string &capture, bool summary = false)
+    {
+        std::ostringstream out;
+        DisasmOptions options;
+        options.summary_only = summary;
+        if (!disasm_capture(defs, capture, out, options))
+            return "<not a capture>";
+        return out.str();
+    }
+
+    bool contains(const std::string &text, const std::string &what)
+    {
+        if (text.find(what) != std::string::npos)
+            return true;
+        ::webcc_test::record_failure("missing '" + what + "' in:\n" + text);
+        return false;
+    }
+}
+
+TEST(disasm_decodes_commands_and_calls)
+{
+    SchemaDefs defs = load_defs(std::string(WEBCC_SCHEMA_DEF));
+    CaptureWriter cap(1);
+
+    // Frame 0: create_canvas("c") is a return-value call: args are the
+    // string's (ptr, len) then the doubles, and the span carries the bytes.
+    cap.head(CAPTURE_CALL, 0);
+    const char name[] = "webcc_canvas_create_canvas";
+    cap.u32(sizeof(name) - 1);
+    cap.bytes(name, sizeof(name) - 1);
+    cap.u32(4);
+    cap.f64(4096);
+    cap.f64(1);
+    cap.f64(640);
+    cap.f64(480);
+    cap.u32(1);
+    cap.u32(4096);
+    cap.u32(1);
+    cap.bytes("c", 1);
+
+    // Frame 1: fill_rect(3, 1, 2, 3.5, 4), then an interned font.
+    CommandBuffer::reset();
+    if (CommandCursor c = CommandBuffer::reserve(48))
+    {
+        c.u32(opcode_of(defs, "fill_rect"));
+        c.i32(3);
+        c.f64(1);
+        c.f64(2);
+        c.f64(3.5);
+        c.f64(4);
+        CommandBuffer::commit(c);
+    }
+    if (CommandCursor c = CommandBuffer::reserve(32))
+    {
+        c.u32(OP_INTERN);
+        c.u32(7);
+        c.str("12px serif", 10);
+        c.u32(opcode_of(defs, "set_font"));
+        c.i32(3);
+        c.u32(0x80000000u | 7);
+        CommandBuffer::commit(c);
+    }
+    cap.flush(1);
+
+    std::string text = disasm(defs, cap.out);
+    contains(text, "frame 0\n  call canvas.create_canvas(\"c\", 640, 480)\n");
+    contains(text, "canvas.fill_rect handle=3 x=1 y=2 w=3.5 h=4\n");
+    contains(text, "webcc.intern id=7 \"12px serif\"\n");
+    contains(text, "canvas.set_font handle=3 font=#7\"12px serif\"\n");
+    contains(text, "2 frames, 1 flushes, 3 commands, ");
+    contains(text, "canvas.create_canvas");
+
+    // --summary drops the listing but keeps the statistics.
+    std::string summary = disasm(defs, cap.out, true);
+    CHECK(summary.find("fill_rect handle=") == std::string::npos);
+    contains(summary, "bytes/frame: min 0, avg ");
+}
+
+TEST(disasm_reports_unknown_opcodes_and_bad_files)
+{
+    SchemaDefs defs = load_defs(std::string(WEBCC_SCHEMA_DEF));
+    CaptureWriter cap(1);
+    CommandBuffer::reset();
+    CommandBuffer::push_u32(0xEE);
+    CommandBuffer::push_u32(0);
+    cap.flush(0);
+
+    std::string text = disasm(defs, cap.out);
+    contains(text, "?? unknown opcode 0xee; rest of flush skipped");
+    CHECK_EQ(disasm(defs, "not a capture"), std::string("<not a capture>"));
+}
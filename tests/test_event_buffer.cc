@@ -0,0 +1,279 @@
+// Tests for the event ring (src/core/event_buffer.h). The producer here does
+// what the generated push_event_* helpers do in app.js (JS_EVENT_RING in
+// js_templates.h): reserve the worst case, write a skip marker when the
+// record would straddle the end, write the record and publish `head`.
+#include "framework.h"
+#include "event_buffer.h"
+#include "webcc/core/stats.h"
+
+#include <cstring>
+
+using namespace webcc;
+
+// The stats clock app.js provides (webcc_stats_now_us), driven by the tests.
+static uint32_t g_now_us = 0;
+extern "C" uint32_t webcc_stats_now_us() { return g_now_us; }
+
+namespace
+{
+    EventRing &ring() { return *(EventRing *)webcc_event_offset_ptr(); }
+    const uint32_t CAP = webcc_event_buffer_capacity();
+
+    // Puts every counter at `at`, empty.
+    void start_at(uint32_t at)
+    {
+        ring() = EventRing{};
+        ring().head = ring().tail = ring().read = at;
+    }
+
+    // One record of `payload` bytes (a multiple of 4), stamped like a --stats
+    // build does when `stamp` is given. False when full.
+    bool push(uint8_t opcode, const void *payload, uint32_t n, const uint32_t *stamp = nullptr)
+    {
+        uint8_t *buf = webcc_event_buffer_ptr();
+        uint32_t header = stamp ? 8 : 4;
+        uint32_t need = header + n;
+        uint32_t head = ring().head;
+        uint32_t used = head - ring().tail;
+        uint32_t pos = head & (CAP - 1);
+        uint32_t skip = pos + need > CAP ? CAP - pos : 0;
+        if (used + skip + need > CAP)
+        {
+            ring().dropped++;
+            return false;
+        }
+        if (skip)
+        {
+            buf[pos] = 0;
+            pos = 0;
+        }
+        buf[pos] = opcode;
+        buf[pos + 1] = stamp ? EVENT_STAMPED : 0;
+        buf[pos + 2] = need & 0xFF;
+        buf[pos + 3] = need >> 8;
+        if (stamp)
+            std::memcpy(buf + pos + 4, stamp, 4);
+        std::memcpy(buf + pos + header, payload, n);
+        head += skip + need;
+        if (head - ring().tail > ring().high_water)
+            ring().high_water = head - ring().tail;
+        ring().head = head;
+        return true;
+    }
+
+    bool push_i32(uint8_t opcode, int32_t v) { return push(opcode, &v, 4); }
+
+    // Polls one event and returns its first i32, or -1 if there was none.
+    int32_t poll()
+    {
+        uint8_t op;
+        const uint8_t *data;
+        uint32_t len;
+        if (!next_event(op, &data, len))
+            return -1;
+        int32_t v = 0;
+        if (len >= 4)
+            std::memcpy(&v, data, 4);
+        return v;
+    }
+}
+
+TEST(event_ring_delivers_in_order_and_releases_on_next_poll)
+{
+    start_at(0);
+    CHECK(push_i32(1, 10));
+    CHECK(push_i32(2, 20));
+    CHECK_EQ(event_buffer_size(), 16u);
+
+    uint8_t op;
+    const uint8_t *data;
+    uint32_t len;
+    CHECK(next_event(op, &data, len));
+    CHECK_EQ((int)op, 1);
+    CHECK_EQ(len, 4u);
+    // Handed out but still owned by the app: the producer cannot reuse it.
+    CHECK_EQ(ring().read, 8u);
+    CHECK_EQ(ring().tail, 0u);
+
+    CHECK_EQ(poll(), 20);
+    CHECK_EQ(ring().tail, 8u);
+    CHECK_EQ(poll(), -1);
+    CHECK_EQ(ring().tail, 16u);
+
+    EventBufferStats s = event_buffer_stats();
+    CHECK_EQ(s.capacity, CAP);
+    CHECK_EQ(s.pending, 0u);
+    CHECK_EQ(s.high_water, 16u);
+}
+
+TEST(event_ring_wraps_with_a_skip_marker)
+{
+    // 4 bytes before the end: an 8-byte record goes to offset 0.
+    start_at(CAP - 4);
+    CHECK(push_i32(3, 33));
+    CHECK_EQ(ring().head, CAP + 8);
+    CHECK_EQ(webcc_event_buffer_ptr()[CAP - 4], 0);
+    CHECK_EQ(poll(), 33);
+    CHECK_EQ(poll(), -1);
+    CHECK_EQ(ring().tail, CAP + 8);
+}
+
+TEST(event_ring_counters_wrap_around_u32)
+{
+    start_at(0xFFFFFFFCu);
+    CHECK(push_i32(1, 1));
+    CHECK(push_i32(1, 2));
+    CHECK_EQ(ring().head, 16u); // 4 skipped, two 8-byte records
+    CHECK_EQ(poll(), 1);
+    CHECK_EQ(poll(), 2);
+    CHECK_EQ(poll(), -1);
+    CHECK_EQ(event_buffer_size(), 0u);
+}
+
+TEST(event_ring_drops_when_full_and_recovers)
+{
+    start_at(0);
+    static uint8_t big[60000];
+    int pushed = 0;
+    while (push(4, big, sizeof(big)))
+        ++pushed;
+    CHECK_EQ(pushed, (int)(CAP / (sizeof(big) + 4)));
+    CHECK_EQ(ring().dropped, 1u);
+
+    // Reading one frees its space for the producer once released.
+    CHECK(poll() != -1);
+    CHECK(!push(4, big, sizeof(big)));
+    CHECK(poll() != -1);
+    CHECK(push(4, big, sizeof(big)));
+    reset_event_buffer();
+    CHECK_EQ(event_buffer_size(), 0u);
+    CHECK_EQ(poll(), -1);
+}
+
+TEST(event_ring_drops_malformed_records)
+{
+    start_at(0);
+    CHECK(push_i32(1, 5));
+    webcc_event_buffer_ptr()[2] = 2; // size below the header
+    CHECK_EQ(poll(), -1);
+    CHECK_EQ(event_buffer_size(), 0u);
+    CHECK(push_i32(1, 6));
+    CHECK_EQ(poll(), 6);
+}
+
+// A record JS may still fold into is published EVENT_OPEN; next_event()
+// closes it before reading, so a producer's claim (a compare-exchange on the
+// header word) fails from then on.
+TEST(event_ring_closes_open_records_before_reading)
+{
+    start_at(0);
+    CHECK(push_i32(4, 1));
+    uint8_t *buf = webcc_event_buffer_ptr();
+    buf[1] |= EVENT_OPEN;
+    uint32_t *header = (uint32_t *)buf;
+    uint32_t open = *header;
+
+    // The producer claims it and folds another value in.
+    uint32_t expected = open;
+    CHECK(__atomic_compare_exchange_n(header, &expected, open | (EVENT_BUSY << 8), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+    int32_t v = 2;
+    std::memcpy(buf + 4, &v, 4);
+    __atomic_store_n(header, open, __ATOMIC_RELEASE);
+
+    CHECK_EQ(poll(), 2);
+    CHECK_EQ(buf[1] & EVENT_OPEN, 0);
+    expected = open;
+    CHECK(!__atomic_compare_exchange_n(header, &expected, open | (EVENT_BUSY << 8), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+    CHECK_EQ(poll(), -1);
+}
+
+TEST(event_ring_subscriptions_set_the_muted_bits)
+{
+    start_at(0);
+    CHECK(event_subscribed(5));
+    unsubscribe_event(5);
+    unsubscribe_event(37);
+    CHECK(!event_subscribed(5));
+    CHECK(!event_subscribed(37));
+    CHECK(event_subscribed(6));
+    // app.js tests muted[op >> 5] bit (op & 31).
+    CHECK_EQ(ring().muted[0], 1u << 5);
+    CHECK_EQ(ring().muted[1], 1u << 5);
+    subscribe_event(5);
+    CHECK(event_subscribed(5));
+    CHECK_EQ(ring().muted[0], 0u);
+    subscribe_event(37);
+}
+
+TEST(event_ring_stamped_records_feed_latency_histograms)
+{
+    start_at(0);
+    stats::reset();
+    int32_t v = 7;
+    uint32_t stamp = 0xFFFFFF00u; // the u32 microsecond clock wraps
+    CHECK(push(3, &v, 4, &stamp));
+
+    g_now_us = 0x100; // 512 us later
+    uint8_t op;
+    const uint8_t *data;
+    uint32_t len;
+    CHECK(next_event(op, &data, len));
+    CHECK_EQ(len, 4u);
+    CHECK_EQ(*(const int32_t *)data, 7);
+
+    const stats::EventLatency &lat = stats::event_latency(3);
+    CHECK_EQ(lat.drain.samples, 1u);
+    CHECK_EQ(lat.drain.max_us, 512u);
+    CHECK_EQ(lat.drain.p50(), 512u);
+    CHECK_EQ(lat.flush.samples, 0u);
+
+    // The flush after the drain closes the loop.
+    g_now_us = 0x100 + 1000;
+    detail::stats_flushed(FlushReason::Explicit);
+    CHECK_EQ(lat.flush.samples, 1u);
+    CHECK_EQ(lat.flush.max_us, 1512u);
+    CHECK(poll() == -1);
+    stats::reset();
+    CHECK_EQ(lat.drain.samples, 0u);
+}
+
+TEST(latency_histogram_percentiles_are_bucket_upper_bounds)
+{
+    stats::LatencyHistogram h = {};
+    CHECK_EQ(h.p50(), 0u);
+    // 90 samples in [1024, 1279], 10 in [4096, 5119].
+    h.counts[36] = 90;
+    h.counts[44] = 10;
+    h.samples = 100;
+    h.max_us = 5000;
+    CHECK_EQ(h.p50(), 1279u);
+    CHECK_EQ(h.percentile(0.90), 1279u);
+    CHECK_EQ(h.p95(), 5000u); // capped at the largest sample
+    CHECK_EQ(h.p99(), 5000u);
+}
+
+TEST(event_ring_payload_pointers_are_not_event_data)
+{
+    // [handle][len | DETACHED][ptr] and the pointer again at the end. Host
+    // pointers do not fit the wasm32 field, so the block is null here.
+    start_at(0);
+    uint32_t fields[4] = {7, 100000u | EVENT_DETACHED, 0, 0};
+    CHECK(push(2, fields, sizeof(fields)));
+    webcc_event_buffer_ptr()[1] = 1 << 4; // one out-of-band payload
+
+    uint8_t op;
+    const uint8_t *data;
+    uint32_t len;
+    CHECK(next_event(op, &data, len));
+    CHECK_EQ(len, 12u);
+    CHECK_EQ(*(const uint32_t *)(data + 4), 100000u | EVENT_DETACHED);
+    CHECK(adopt_event_payload(nullptr));
+    CHECK(!adopt_event_payload(nullptr)); // adopted once
+    CHECK_EQ(poll(), -1);
+
+    // A record claiming more pointers than it has room for is malformed.
+    CHECK(push_i32(2, 1));
+    webcc_event_buffer_ptr()[ring().head - 8 + 1] = 2 << 4;
+    CHECK_EQ(poll(), -1);
+    CHECK_EQ(event_buffer_size(), 0u);
+}
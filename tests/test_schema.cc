@@ -124,6 +124,52 @@ TEST(schema_parses_event_params)
     CHECK_EQ(e->params[2].name, std::string("y"));
 }
 
+TEST(schema_parses_event_coalescing)
+{
+    std::string path = write_temp(
+        "input|event|MOUSE_MOVE|int32:x int32:y|coalesce=last\n"
+        "input|event|WHEEL|float32:dx float32:dy|coalesce=accumulate\n"
+        "input|event|KEY_DOWN|int32:key_code\n",
+        "event_coalesce");
+    SchemaDefs d = load_defs(path);
+    std::remove(path.c_str());
+
+    CHECK(find_event(d, "MOUSE_MOVE")->coalesce == Coalesce::Last);
+    CHECK(find_event(d, "WHEEL")->coalesce == Coalesce::Accumulate);
+    CHECK(find_event(d, "KEY_DOWN")->coalesce == Coalesce::None);
+    CHECK_EQ(find_event(d, "WHEEL")->params.size(), (size_t)2);
+
+    std::string cache = "/tmp/webcc_test_coalesce_cache.bin";
+    CHECK(save_defs_binary(d, cache));
+    SchemaDefs loaded;
+    CHECK(load_defs_binary(loaded, cache));
+    std::remove(cache.c_str());
+    CHECK(find_event(loaded, "MOUSE_MOVE")->coalesce == Coalesce::Last);
+    CHECK(find_event(loaded, "WHEEL")->coalesce == Coalesce::Accumulate);
+}
+
+TEST(schema_parses_event_batching)
+{
+    std::string path = write_temp(
+        "input|event|POINTER|int32:id float32:x float64:time|batch=32\n"
+        "input|event|KEY_DOWN|int32:key_code\n",
+        "event_batch");
+    SchemaDefs d = load_defs(path);
+    std::remove(path.c_str());
+
+    CHECK_EQ((int)find_event(d, "POINTER")->batch, 32);
+    CHECK(find_event(d, "POINTER")->coalesce == Coalesce::None);
+    CHECK_EQ((int)find_event(d, "KEY_DOWN")->batch, 0);
+
+    std::string cache = "/tmp/webcc_test_batch_cache.bin";
+    CHECK(save_defs_binary(d, cache));
+    SchemaDefs loaded;
+    CHECK(load_defs_binary(loaded, cache));
+    std::remove(cache.c_str());
+    CHECK_EQ((int)find_event(loaded, "POINTER")->batch, 32);
+    CHECK_EQ((int)find_event(loaded, "KEY_DOWN")->batch, 0);
+}
+
 TEST(schema_parses_inheritance)
 {
     std::string path = write_temp(
@@ -155,6 +201,55 @@ TEST(schema_action_preserves_pipes_in_js_body)
     CHECK_EQ(c->action, std::string("{ return a || 0; }"));
 }
 
+TEST(schema_parses_wire_options)
+{
+    std::string path = write_temp(
+        "meta|wire|compact\n"
+        "meta|precision|canvas|float32\n"
+        "meta|precision|canvas::ARC|float64\n"
+        "meta|bind|CanvasContext2D\n"
+        "canvas|command|FILL_RECT|fill_rect|handle(CanvasContext2D):handle float64:x float64:y|{}\n"
+        "canvas|command|ARC|arc|handle(CanvasContext2D):handle float64:r|{}\n"
+        "canvas|command|SET_SIZE|set_size|handle(Canvas):handle float64:w|{}\n"
+        "canvas|command|MEASURE|measure|handle(CanvasContext2D):handle RET:float64|{ return 0; }\n"
+        "dom|command|SET_X|set_x|handle(DOMElement):handle float64:x|{}\n",
+        "wire");
+    SchemaDefs d = load_defs(path);
+    std::remove(path.c_str());
+
+    CHECK_EQ(d.wire_version, 2);
+    const SchemaCommand *fill = find_cmd(d, "FILL_RECT");
+    const SchemaCommand *arc = find_cmd(d, "ARC");
+    const SchemaCommand *size = find_cmd(d, "SET_SIZE");
+    const SchemaCommand *measure = find_cmd(d, "MEASURE");
+    const SchemaCommand *set_x = find_cmd(d, "SET_X");
+    CHECK(fill && arc && size && measure && set_x);
+    if (!fill || !arc || !size || !measure || !set_x)
+        return;
+    CHECK(fill->compact && set_x->compact);
+    // Namespace precision applies; a command-level entry overrides it.
+    CHECK(fill->narrow_floats);
+    CHECK(!arc->narrow_floats);
+    CHECK(!set_x->narrow_floats);
+    // Only the bound handle type (exactly) gets a register, and only for
+    // buffered (void) commands.
+    CHECK_EQ(fill->bind_slot, 0);
+    CHECK_EQ(size->bind_slot, -1);
+    CHECK_EQ(measure->bind_slot, -1);
+}
+
+TEST(schema_defaults_to_v1_wire_format)
+{
+    std::string path = write_temp("canvas|command|FILL_RECT|fill_rect|handle(CanvasContext2D):handle float64:x|{}\n", "wire_v1");
+    SchemaDefs d = load_defs(path);
+    std::remove(path.c_str());
+
+    CHECK_EQ(d.wire_version, 1);
+    CHECK(!d.commands[0].compact);
+    CHECK(!d.commands[0].narrow_floats);
+    CHECK_EQ(d.commands[0].bind_slot, -1);
+}
+
 // ---- Binary cache round-trip --------------------------------------------
 
 TEST(binary_cache_roundtrips_real_schema)
@@ -199,6 +294,32 @@ TEST(binary_cache_roundtrips_real_schema)
     }
 }
 
+TEST(binary_cache_roundtrips_wire_options)
+{
+    std::string path = write_temp(
+        "meta|wire|compact\n"
+        "meta|precision|canvas|float32\n"
+        "meta|bind|CanvasContext2D\n"
+        "canvas|command|FILL_RECT|fill_rect|handle(CanvasContext2D):handle float64:x|{}\n",
+        "wire_cache");
+    SchemaDefs original = load_defs(path);
+    std::remove(path.c_str());
+
+    std::string cache = "/tmp/webcc_test_wire_cache.bin";
+    CHECK(save_defs_binary(original, cache));
+    SchemaDefs loaded;
+    CHECK(load_defs_binary(loaded, cache));
+    std::remove(cache.c_str());
+
+    CHECK_EQ(loaded.wire_version, 2);
+    CHECK_EQ(loaded.precision.size(), (size_t)1);
+    CHECK_EQ(loaded.bound_types.size(), (size_t)1);
+    // Per-command options are re-resolved on load.
+    CHECK(loaded.commands[0].compact);
+    CHECK(loaded.commands[0].narrow_floats);
+    CHECK_EQ(loaded.commands[0].bind_slot, 0);
+}
+
 TEST(binary_cache_rejects_bad_magic)
 {
     std::string path = "/tmp/webcc_test_badmagic.bin";